@@ -23,23 +23,39 @@
 
 #include "libsmipc/ring-buffer/atomic-spin-lock.hpp"
 
+AtomicSpinLock::AtomicSpinLock(std::atomic_bool& flag, WaitStrategy strategy, std::atomic<uint64_t>* spinCount) noexcept
+	: m_flag {flag}
+	, m_strategy {strategy}
+	, m_spinCount {spinCount}
+{}
+
 void AtomicSpinLock::lock() noexcept
 {
+	Waiter waiter {m_strategy};
+	uint64_t spins {0u};
+
 	while (! tryLock())
 	{
-		;
+		// Only read while the lock is held, the exchange is retried once it looks free
+		while (m_flag.load(std::memory_order_relaxed))
+		{
+			waiter.wait();
+			++spins;
+		}
+	}
+
+	if (spins > 0u && m_spinCount != nullptr)
+	{
+		m_spinCount->store(m_spinCount->load(std::memory_order_relaxed) + spins, std::memory_order_relaxed);
 	}
 }
 
 void AtomicSpinLock::unlock() noexcept
 {
-	std::atomic_thread_fence(std::memory_order_release);
-	m_lock.store(false, std::memory_order_relaxed);
+	m_flag.store(false, std::memory_order_release);
 }
 
 bool AtomicSpinLock::tryLock() noexcept
 {
-	bool x {m_lock.exchange(true, std::memory_order_relaxed)};
-	std::atomic_thread_fence(std::memory_order_acquire);
-	return x;
+	return ! m_flag.exchange(true, std::memory_order_acquire);
 }
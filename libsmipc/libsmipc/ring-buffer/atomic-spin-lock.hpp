@@ -24,17 +24,39 @@
 #ifndef ATOMIC_SPIN_LOCK_H_
 #define ATOMIC_SPIN_LOCK_H_
 
+#include <libsmipc/ring-buffer/wait-strategy.hpp>
+
 #include <atomic>
+#include <cstdint>
 
+/**
+ * Test-and-test-and-set spin lock on a flag that may live in shared memory.
+ *
+ * Waiters spin on a plain load and only retry the exchange once the flag
+ * reads clear, so the cache line is not bounced between them while the lock
+ * is held. Waiting follows the given wait strategy. If a spin counter is
+ * given, every wait is added to it, the counter must only be written by
+ * this side.
+ */
 class AtomicSpinLock
 {
 public:
+	AtomicSpinLock(std::atomic_bool& flag, WaitStrategy strategy = WaitStrategy::Backoff, std::atomic<uint64_t>* spinCount = nullptr) noexcept;
+	AtomicSpinLock(const AtomicSpinLock&) = delete;
+	AtomicSpinLock& operator=(const AtomicSpinLock&) = delete;
+
 	void lock() noexcept;
 	void unlock() noexcept;
+
+	/**
+	 * @return True if the lock was taken.
+	 */
 	bool tryLock() noexcept;
 
 private:
-	std::atomic_bool m_lock;
+	std::atomic_bool& m_flag;
+	WaitStrategy m_strategy;
+	std::atomic<uint64_t>* m_spinCount;
 };
 
 #endif  // ATOMIC_SPIN_LOCK_H_
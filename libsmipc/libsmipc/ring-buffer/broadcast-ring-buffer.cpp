@@ -0,0 +1,265 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/broadcast-ring-buffer.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+BroadcastRingBuffer::BroadcastRingBuffer(uint8_t* memory, std::size_t size)
+	: m_memory {memory, size}
+	, header {reinterpret_cast<BroadcastRingBufferHeader*>(m_memory.data())}
+	, data {m_memory.begin() + sizeof(BroadcastRingBufferHeader), size - sizeof(BroadcastRingBufferHeader)}
+{
+	if (reinterpret_cast<uintptr_t>(memory) % kCacheLineSize != 0u)
+	{
+		throw std::invalid_argument("Memory must be 64 byte aligned");
+	}
+
+	if (size % kAlignment != 0u)
+	{
+		throw std::invalid_argument("Buffer size must be a multiple of 4");
+	}
+
+	if (size <= sizeof(BroadcastRingBufferHeader))
+	{
+		throw std::invalid_argument("Buffer size is too small");
+	}
+
+	if (size > 2048u * 1024u * 1024u)
+	{
+		throw std::invalid_argument("Buffer size is too large, must be less than 2GB");
+	}
+
+	// Whichever side claims the header lays it out, the others wait for it and validate it
+	const uint32_t version {ClaimRingBufferHeader(header->version)};
+
+	if (version == 0u)
+	{
+		header->capacity = getCapacity();
+		header->version.store(kBroadcastRingBufferVersion, std::memory_order_release);
+	}
+	else if (version != kBroadcastRingBufferVersion)
+	{
+		throw std::invalid_argument("Unsupported ring buffer header version");
+	}
+	else if (header->capacity != getCapacity())
+	{
+		throw std::invalid_argument("Buffer size does not match the existing ring buffer");
+	}
+}
+
+void BroadcastRingBuffer::copyIn(uint64_t position, std::span<const uint8_t> source) noexcept
+{
+	const uint32_t start {getOffset(position)};
+	const std::size_t part1Size {std::min<std::size_t>(source.size(), data.size() - start)};
+
+	std::copy_n(std::cbegin(source), part1Size, std::begin(data) + start);
+	std::copy_n(std::cbegin(source) + part1Size, source.size() - part1Size, std::begin(data));
+}
+
+void BroadcastRingBuffer::copyOut(uint64_t position, std::span<uint8_t> destination) const noexcept
+{
+	const uint32_t start {getOffset(position)};
+	const std::size_t part1Size {std::min<std::size_t>(destination.size(), data.size() - start)};
+
+	std::copy_n(std::cbegin(data) + start, part1Size, std::begin(destination));
+	std::copy_n(std::cbegin(data), destination.size() - part1Size, std::begin(destination) + part1Size);
+}
+
+BroadcastTxRingBuffer::BroadcastTxRingBuffer(uint8_t* memory, std::size_t size)
+	: BroadcastRingBuffer {memory, size}
+{}
+
+void BroadcastTxRingBuffer::push(const Packet& packet)
+{
+	if (tryPush(packet) == RingBufferStatus::TooLarge)
+	{
+		throw std::overflow_error("Buffer overflow");
+	}
+}
+
+[[nodiscard]]
+auto BroadcastTxRingBuffer::tryPush(const Packet& packet) noexcept -> RingBufferStatus
+{
+	// If the data size is 0, there is nothing to do
+	if (packet.data.size() == 0)
+	{
+		return RingBufferStatus::Ok;
+	}
+
+	if (packet.data.size() > getCapacity() || kPacketHeaderSize + AlignedSize(static_cast<uint32_t>(packet.data.size())) > getCapacity())
+	{
+		return RingBufferStatus::TooLarge;
+	}
+
+	const uint32_t dataSize {static_cast<uint32_t>(packet.data.size())};
+	const uint64_t position {header->tail.load(std::memory_order_relaxed)};
+	const uint64_t next {position + kPacketHeaderSize + AlignedSize(dataSize)};
+
+	// Readers that copy anything below next - capacity from here on will see the intent and discard it
+	header->tailIntent.store(next, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	PacketHeader tmpHeader {packet.header};
+	tmpHeader.size = dataSize;
+	copyIn(position, {reinterpret_cast<const uint8_t*>(&tmpHeader), kPacketHeaderSize});
+	copyIn(position + kPacketHeaderSize, packet.data);
+
+	header->latest.store(position, std::memory_order_release);
+	header->tail.store(next, std::memory_order_release);
+
+	return RingBufferStatus::Ok;
+}
+
+[[nodiscard]]
+auto BroadcastTxRingBuffer::getSubscriberCount() const noexcept -> std::size_t
+{
+	return std::ranges::count_if(header->subscribers, [](const Subscriber& subscriber)
+		{
+			return subscriber.active.load(std::memory_order_relaxed);
+		});
+}
+
+[[nodiscard]]
+auto BroadcastTxRingBuffer::getMaxLag() const noexcept -> uint64_t
+{
+	const uint64_t tail {header->tail.load(std::memory_order_relaxed)};
+	uint64_t lag {0u};
+
+	for (const auto& subscriber : header->subscribers)
+	{
+		if (subscriber.active.load(std::memory_order_acquire))
+		{
+			lag = std::max(lag, tail - subscriber.cursor.load(std::memory_order_relaxed));
+		}
+	}
+
+	return lag;
+}
+
+BroadcastRxRingBuffer::BroadcastRxRingBuffer(uint8_t* memory, std::size_t size)
+	: BroadcastRingBuffer {memory, size}
+{
+	for (auto& subscriber : header->subscribers)
+	{
+		bool expected {false};
+
+		if (subscriber.active.compare_exchange_strong(expected, true, std::memory_order_acquire))
+		{
+			m_subscriber = &subscriber;
+			break;
+		}
+	}
+
+	if (m_subscriber == nullptr)
+	{
+		throw std::runtime_error("No free subscriber slots");
+	}
+
+	m_subscriber->overrunCount.store(0u, std::memory_order_relaxed);
+	m_subscriber->cursor.store(header->tail.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+BroadcastRxRingBuffer::~BroadcastRxRingBuffer()
+{
+	m_subscriber->active.store(false, std::memory_order_release);
+}
+
+[[nodiscard]]
+auto BroadcastRxRingBuffer::isEmpty() const noexcept -> bool
+{
+	return m_subscriber->cursor.load(std::memory_order_relaxed) == header->tail.load(std::memory_order_acquire);
+}
+
+[[nodiscard]]
+auto BroadcastRxRingBuffer::getOverrunCount() const noexcept -> uint64_t
+{
+	return m_subscriber->overrunCount.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]]
+auto BroadcastRxRingBuffer::pull() -> Packet
+{
+	Packet packet;
+
+	switch (tryPull(packet))
+	{
+		case RingBufferStatus::Empty:
+			throw std::runtime_error("No packets in buffer");
+		case RingBufferStatus::Overrun:
+			throw std::out_of_range("Packets were overwritten before being read");
+		default:
+			return packet;
+	}
+}
+
+[[nodiscard]]
+auto BroadcastRxRingBuffer::tryPull(Packet& packet) -> RingBufferStatus
+{
+	const uint64_t cursor {m_subscriber->cursor.load(std::memory_order_relaxed)};
+	const uint64_t tail {header->tail.load(std::memory_order_acquire)};
+
+	if (cursor == tail)
+	{
+		return RingBufferStatus::Empty;
+	}
+
+	if (isOverrun(cursor, tail))
+	{
+		return skipToLatest();
+	}
+
+	// The writer may be overwriting what we copy, nothing read is trusted until validated below
+	PacketHeader packetHeader {};
+	copyOut(cursor, {reinterpret_cast<uint8_t*>(&packetHeader), kPacketHeaderSize});
+
+	if (packetHeader.size > getCapacity() - kPacketHeaderSize)
+	{
+		return skipToLatest();
+	}
+
+	packet.data.resize(packetHeader.size);
+	copyOut(cursor + kPacketHeaderSize, packet.data);
+
+	// Pairs with the fence after the writer's intent, a lap that started during the copy is seen here
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (isOverrun(cursor, header->tailIntent.load(std::memory_order_relaxed)))
+	{
+		return skipToLatest();
+	}
+
+	packet.header = packetHeader;
+	m_subscriber->cursor.store(cursor + kPacketHeaderSize + AlignedSize(packetHeader.size), std::memory_order_relaxed);
+
+	return RingBufferStatus::Ok;
+}
+
+auto BroadcastRxRingBuffer::skipToLatest() noexcept -> RingBufferStatus
+{
+	m_subscriber->cursor.store(header->latest.load(std::memory_order_acquire), std::memory_order_relaxed);
+	m_subscriber->overrunCount.fetch_add(1u, std::memory_order_relaxed);
+
+	return RingBufferStatus::Overrun;
+}
@@ -0,0 +1,210 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BROADCAST_RING_BUFFER_H_
+#define BROADCAST_RING_BUFFER_H_
+
+#include <libsmipc/ring-buffer/packet.hpp>
+#include <libsmipc/ring-buffer/ring-buffer.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+// Different from the other ring versions, so opening a ring with the wrong type fails
+static constexpr uint32_t kBroadcastRingBufferVersion {0x42520001u};
+static constexpr std::size_t kBroadcastMaxSubscribers {256u};
+
+/**
+ * A ring buffer written once by a single producer and read by every
+ * subscriber, so a notification for N clients costs one copy instead of N.
+ *
+ * The writer never waits for readers. It announces how far it is about to
+ * write before copying a packet in, and a reader validates each packet it
+ * copied out against that announcement afterwards. A reader that fell more
+ * than a capacity behind has had packets overwritten, it is told so with
+ * RingBufferStatus::Overrun and moved forward to the latest packet.
+ *
+ * Each subscriber owns a slot in the header holding its read cursor, so the
+ * writer side can see how far behind every reader is. Cursors are 64 bit byte
+ * positions that never wrap.
+ */
+class BroadcastRingBuffer
+{
+public:
+	struct Subscriber
+	{
+		alignas(kCacheLineSize) std::atomic<uint64_t> cursor {};
+		std::atomic<uint64_t> overrunCount {};
+		std::atomic_bool active {false};
+	};
+
+	struct BroadcastRingBufferHeader
+	{
+		// Written once on initialisation
+		alignas(kCacheLineSize) std::atomic<uint32_t> version {};
+		uint32_t capacity {};
+
+		// Only written by the writer
+		alignas(kCacheLineSize) std::atomic<uint64_t> tailIntent {};
+		std::atomic<uint64_t> tail {};
+		std::atomic<uint64_t> latest {};
+
+		// One slot per subscriber, each only written by its owner
+		std::array<Subscriber, kBroadcastMaxSubscribers> subscribers {};
+	};
+
+	static_assert(sizeof(BroadcastRingBufferHeader) % kCacheLineSize == 0u);
+	static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+	BroadcastRingBuffer(uint8_t* memory, std::size_t size);
+	~BroadcastRingBuffer() = default;
+
+	[[nodiscard]]
+	auto getMemoryBlockSize() const noexcept -> uint32_t
+	{
+		return static_cast<uint32_t>(m_memory.size());
+	}
+
+	[[nodiscard]]
+	auto getCapacity() const noexcept -> uint32_t
+	{
+		return static_cast<uint32_t>(data.size());
+	}
+
+	/**
+	 * Get the size of the memory block needed for a given data capacity.
+	 *
+	 * @param capacity The number of bytes available to packets.
+	 * @return The capacity plus the header overhead.
+	 */
+	[[nodiscard]]
+	static constexpr auto GetMemoryBlockSize(std::size_t capacity) noexcept -> std::size_t
+	{
+		return sizeof(BroadcastRingBufferHeader) + capacity;
+	}
+
+private:
+	std::span<uint8_t> m_memory {};
+
+protected:
+	[[nodiscard]]
+	auto getOffset(uint64_t position) const noexcept -> uint32_t
+	{
+		return static_cast<uint32_t>(position % getCapacity());
+	}
+
+	void copyIn(uint64_t position, std::span<const uint8_t> source) noexcept;
+	void copyOut(uint64_t position, std::span<uint8_t> destination) const noexcept;
+
+	BroadcastRingBufferHeader* header {};
+	std::span<uint8_t> data {};
+};
+
+class BroadcastTxRingBuffer: public BroadcastRingBuffer
+{
+public:
+	BroadcastTxRingBuffer(uint8_t* memory, std::size_t size);
+	~BroadcastTxRingBuffer() = default;
+
+	/**
+	 * Publish a packet to every subscriber, overwriting the oldest packets.
+	 *
+	 * @param packet The packet to publish, empty packets are skipped.
+	 * @throws std::overflow_error if the packet can never fit in the buffer.
+	 */
+	void push(const Packet& packet);
+
+	/**
+	 * @return Ok once published, TooLarge if the packet can never fit. A
+	 * broadcast ring is never full.
+	 */
+	[[nodiscard]]
+	auto tryPush(const Packet& packet) noexcept -> RingBufferStatus;
+
+	[[nodiscard]]
+	auto getSubscriberCount() const noexcept -> std::size_t;
+
+	/**
+	 * Get how many bytes the slowest subscriber has still to read, anything
+	 * over the capacity has been lost to it.
+	 */
+	[[nodiscard]]
+	auto getMaxLag() const noexcept -> uint64_t;
+};
+
+class BroadcastRxRingBuffer: private BroadcastRingBuffer
+{
+public:
+	/**
+	 * Subscribe to the ring, starting with the next packet published.
+	 *
+	 * @throws std::runtime_error if every subscriber slot is taken.
+	 */
+	BroadcastRxRingBuffer(uint8_t* memory, std::size_t size);
+	~BroadcastRxRingBuffer();
+
+	BroadcastRxRingBuffer(const BroadcastRxRingBuffer&) = delete;
+	auto operator=(const BroadcastRxRingBuffer&) -> BroadcastRxRingBuffer& = delete;
+
+	using BroadcastRingBuffer::getCapacity;
+	using BroadcastRingBuffer::getMemoryBlockSize;
+
+	[[nodiscard]]
+	auto isEmpty() const noexcept -> bool;
+
+	[[nodiscard]]
+	auto getOverrunCount() const noexcept -> uint64_t;
+
+	/**
+	 * @throws std::runtime_error if the buffer is empty.
+	 * @throws std::out_of_range if packets were overwritten before being read,
+	 * the next pull continues from the latest packet.
+	 */
+	[[nodiscard]]
+	auto pull() -> Packet;
+
+	/**
+	 * Pull the next packet without throwing, reusing the storage of `packet`.
+	 *
+	 * @return Ok once pulled, Empty if there is nothing new, Overrun if packets
+	 * were overwritten before being read. After an overrun `packet` is left
+	 * untouched and the next pull continues from the latest packet.
+	 */
+	[[nodiscard]]
+	auto tryPull(Packet& packet) -> RingBufferStatus;
+
+private:
+	[[nodiscard]]
+	auto isOverrun(uint64_t cursor, uint64_t end) const noexcept -> bool
+	{
+		return end - cursor > getCapacity();
+	}
+
+	auto skipToLatest() noexcept -> RingBufferStatus;
+
+	Subscriber* m_subscriber {};
+};
+
+#endif  // BROADCAST_RING_BUFFER_H_
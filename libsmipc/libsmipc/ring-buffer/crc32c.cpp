@@ -0,0 +1,276 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/crc32c.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	include <nmmintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#		define CRC32C_TARGET
+#	else
+#		define CRC32C_TARGET __attribute__((target("sse4.2")))
+#	endif
+#	define CRC32C_HARDWARE
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#	include <arm_acle.h>
+#	define CRC32C_TARGET
+#	define CRC32C_HARDWARE
+#endif
+
+// Reflected form of the Castagnoli polynomial 0x1EDC6F41
+static constexpr uint32_t kCrc32cPolynomial {0x82F63B78u};
+
+// Large inputs are checksummed as three interleaved streams of these lengths, which hides the latency of the crc32 instruction
+static constexpr std::size_t kLongBlock {8192u};
+static constexpr std::size_t kShortBlock {256u};
+
+/**
+ * Multiply two polynomials modulo the CRC polynomial, bit reflected.
+ */
+static constexpr auto MultiplyModP(uint32_t a, uint32_t b) noexcept -> uint32_t
+{
+	uint32_t product {0u};
+
+	for (uint32_t m = 1u << 31u; m != 0u; m >>= 1u)
+	{
+		if ((a & m) != 0u)
+		{
+			product ^= b;
+		}
+
+		b = (b & 1u) != 0u ? (b >> 1u) ^ kCrc32cPolynomial : b >> 1u;
+	}
+
+	return product;
+}
+
+/**
+ * Get x^(8 * bytes) modulo the CRC polynomial. Multiplying a CRC register by
+ * it has the same effect as feeding that many zero bytes through it, which is
+ * how the interleaved streams are stitched back together.
+ */
+static constexpr auto GetShiftOperator(std::size_t bytes) noexcept -> uint32_t
+{
+	// x^(2^k) for every k, starting from x^1
+	std::array<uint32_t, 32u> powers {};
+	powers[0] = 1u << 30u;
+
+	for (std::size_t k = 1u; k < powers.size(); ++k)
+	{
+		powers[k] = MultiplyModP(powers[k - 1u], powers[k - 1u]);
+	}
+
+	uint32_t result {1u << 31u};
+
+	for (std::size_t k = 3u; bytes != 0u; bytes >>= 1u, ++k)
+	{
+		if ((bytes & 1u) != 0u)
+		{
+			result = MultiplyModP(powers[k % powers.size()], result);
+		}
+	}
+
+	return result;
+}
+
+static constexpr auto MakeByteTable() noexcept -> std::array<uint32_t, 256u>
+{
+	std::array<uint32_t, 256u> table {};
+
+	for (uint32_t n = 0u; n < table.size(); ++n)
+	{
+		uint32_t crc {n};
+
+		for (uint32_t bit = 0u; bit < 8u; ++bit)
+		{
+			crc = (crc & 1u) != 0u ? (crc >> 1u) ^ kCrc32cPolynomial : crc >> 1u;
+		}
+
+		table[n] = crc;
+	}
+
+	return table;
+}
+
+static constexpr uint32_t kLongShift {GetShiftOperator(kLongBlock)};
+static constexpr uint32_t kShortShift {GetShiftOperator(kShortBlock)};
+static constexpr std::array<uint32_t, 256u> kByteTable {MakeByteTable()};
+
+// The helpers below work on the raw CRC register, the public functions do the pre and post inversion
+template <bool kCopy>
+static auto SoftwareCrc32c(const uint8_t* source, uint8_t* destination, std::size_t size, uint32_t crc) noexcept -> uint32_t
+{
+	for (std::size_t i = 0u; i < size; ++i)
+	{
+		if constexpr (kCopy)
+		{
+			destination[i] = source[i];
+		}
+
+		crc = kByteTable[(crc ^ source[i]) & 0xFFu] ^ (crc >> 8u);
+	}
+
+	return crc;
+}
+
+#ifdef CRC32C_HARDWARE
+CRC32C_TARGET static inline auto Step(uint64_t crc, uint64_t value) noexcept -> uint64_t
+{
+#	if defined(__x86_64__) || defined(_M_X64)
+	return _mm_crc32_u64(crc, value);
+#	else
+	return __crc32cd(static_cast<uint32_t>(crc), value);
+#	endif
+}
+
+CRC32C_TARGET static inline auto Step(uint64_t crc, uint8_t value) noexcept -> uint64_t
+{
+#	if defined(__x86_64__) || defined(_M_X64)
+	return _mm_crc32_u8(static_cast<uint32_t>(crc), value);
+#	else
+	return __crc32cb(static_cast<uint32_t>(crc), value);
+#	endif
+}
+
+template <bool kCopy>
+static inline auto Load(const uint8_t* source, uint8_t* destination, std::size_t offset) noexcept -> uint64_t
+{
+	uint64_t value {};
+	std::memcpy(&value, source + offset, sizeof(value));
+
+	if constexpr (kCopy)
+	{
+		std::memcpy(destination + offset, &value, sizeof(value));
+	}
+
+	return value;
+}
+
+template <bool kCopy, std::size_t kBlock>
+CRC32C_TARGET static inline void HardwareInterleaved(const uint8_t*& source, uint8_t*& destination, std::size_t& size, uint64_t& crc, uint32_t shift) noexcept
+{
+	while (size >= 3u * kBlock)
+	{
+		uint64_t crc1 {0u};
+		uint64_t crc2 {0u};
+
+		for (std::size_t i = 0u; i < kBlock; i += sizeof(uint64_t))
+		{
+			crc = Step(crc, Load<kCopy>(source, destination, i));
+			crc1 = Step(crc1, Load<kCopy>(source, destination, kBlock + i));
+			crc2 = Step(crc2, Load<kCopy>(source, destination, 2u * kBlock + i));
+		}
+
+		// The second and third streams started from zero, so shifting and xoring appends them
+		crc = MultiplyModP(shift, static_cast<uint32_t>(crc)) ^ crc1;
+		crc = MultiplyModP(shift, static_cast<uint32_t>(crc)) ^ crc2;
+
+		source += 3u * kBlock;
+		size -= 3u * kBlock;
+
+		if constexpr (kCopy)
+		{
+			destination += 3u * kBlock;
+		}
+	}
+}
+
+template <bool kCopy>
+CRC32C_TARGET static auto HardwareCrc32c(const uint8_t* source, uint8_t* destination, std::size_t size, uint32_t crc) noexcept -> uint32_t
+{
+	uint64_t state {crc};
+
+	HardwareInterleaved<kCopy, kLongBlock>(source, destination, size, state, kLongShift);
+	HardwareInterleaved<kCopy, kShortBlock>(source, destination, size, state, kShortShift);
+
+	std::size_t i {0u};
+
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		state = Step(state, Load<kCopy>(source, destination, i));
+	}
+
+	for (; i < size; ++i)
+	{
+		if constexpr (kCopy)
+		{
+			destination[i] = source[i];
+		}
+
+		state = Step(state, source[i]);
+	}
+
+	return static_cast<uint32_t>(state);
+}
+#endif
+
+[[nodiscard]]
+auto HasHardwareCrc32c() noexcept -> bool
+{
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(_MSC_VER)
+	static const bool hasSse42 {[]()
+		{
+			int info[4] {};
+			__cpuid(info, 1);
+			return (info[2] & (1 << 20)) != 0;
+		}()};
+	return hasSse42;
+#elif defined(__x86_64__)
+	static const bool hasSse42 {__builtin_cpu_supports("sse4.2") != 0};
+	return hasSse42;
+#elif defined(CRC32C_HARDWARE)
+	return true;
+#else
+	return false;
+#endif
+}
+
+template <bool kCopy>
+static auto Checksum(const uint8_t* source, uint8_t* destination, std::size_t size, uint32_t crc) noexcept -> uint32_t
+{
+#ifdef CRC32C_HARDWARE
+	if (HasHardwareCrc32c())
+	{
+		return HardwareCrc32c<kCopy>(source, destination, size, crc);
+	}
+#endif
+
+	return SoftwareCrc32c<kCopy>(source, destination, size, crc);
+}
+
+[[nodiscard]]
+auto Crc32c(std::span<const uint8_t> data, uint32_t crc) noexcept -> uint32_t
+{
+	return ~Checksum<false>(data.data(), nullptr, data.size(), ~crc);
+}
+
+[[nodiscard]]
+auto CopyCrc32c(std::span<const uint8_t> source, uint8_t* destination, uint32_t crc) noexcept -> uint32_t
+{
+	return ~Checksum<true>(source.data(), destination, source.size(), ~crc);
+}
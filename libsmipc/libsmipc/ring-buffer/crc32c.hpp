@@ -0,0 +1,61 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CRC32C_H_
+#define CRC32C_H_
+
+#include <cstdint>
+#include <span>
+
+/**
+ * Checksum data with CRC-32C (Castagnoli), the CRC computed by the SSE4.2 and
+ * ARMv8 crc32c instructions. Those are used when the CPU has them, a table
+ * driven fallback otherwise.
+ *
+ * Checksums chain, Crc32c(b, Crc32c(a)) is the checksum of a followed by b.
+ *
+ * @param data The bytes to checksum.
+ * @param crc The checksum of the bytes before these, 0 to start afresh.
+ * @return The checksum of all bytes so far.
+ */
+[[nodiscard]]
+auto Crc32c(std::span<const uint8_t> data, uint32_t crc = 0u) noexcept -> uint32_t;
+
+/**
+ * Copy data and checksum it in the same pass, so every byte is loaded once.
+ *
+ * @param source The bytes to copy and checksum.
+ * @param destination Where to copy them, with room for source.size() bytes.
+ * @param crc The checksum of the bytes before these, 0 to start afresh.
+ * @return The checksum of all bytes so far.
+ */
+[[nodiscard]]
+auto CopyCrc32c(std::span<const uint8_t> source, uint8_t* destination, uint32_t crc = 0u) noexcept -> uint32_t;
+
+/**
+ * @return True if the checksum runs on CRC instructions rather than tables.
+ */
+[[nodiscard]]
+auto HasHardwareCrc32c() noexcept -> bool;
+
+#endif  // CRC32C_H_
@@ -23,33 +23,51 @@
 
 #include "libsmipc/ring-buffer/dekkar-lock.hpp"
 
-DekkarLock::DekkarLock(std::atomic_bool& flag1, std::atomic_bool& flag2, std::atomic_bool& turn) noexcept
+DekkarLock::DekkarLock(std::atomic_bool& flag1, std::atomic_bool& flag2, std::atomic_bool& turn, bool myTurn, WaitStrategy strategy, std::atomic<uint64_t>* spinCount) noexcept
 	: m_flag1 {flag1}
 	, m_flag2 {flag2}
 	, m_turn {turn}
+	, m_myTurn {myTurn}
+	, m_strategy {strategy}
+	, m_spinCount {spinCount}
 {}
 
 void DekkarLock::lock() noexcept
 {
+	Waiter waiter {m_strategy};
+	uint64_t spins {0u};
 	m_flag1.store(true);
 
 	while (m_flag2.load())
 	{
-		if (m_flag1.load())
+		// Back off while it is the other side's turn, then try again
+		if (m_turn.load() != m_myTurn)
 		{
 			m_flag1.store(false);
-			while (m_turn.load())
+			while (m_turn.load() != m_myTurn)
 			{
-				;
+				waiter.wait();
+				++spins;
 			}
 			m_flag1.store(true);
 		}
+		else
+		{
+			waiter.wait();
+			++spins;
+		}
+	}
+
+	if (spins > 0u && m_spinCount != nullptr)
+	{
+		m_spinCount->store(m_spinCount->load(std::memory_order_relaxed) + spins, std::memory_order_relaxed);
 	}
 }
 
 void DekkarLock::unlock() noexcept
 {
-	m_turn.store(true);
+	// Hand priority to the other side
+	m_turn.store(! m_myTurn);
 	m_flag1.store(false);
 }
 
@@ -63,19 +81,5 @@ bool DekkarLock::tryLock() noexcept
 		return false;
 	}
 
-	if (! m_flag1.load())
-	{
-		m_flag1.store(false);
-		return false;
-	}
-
-	m_flag1.store(false);
-
-	if (m_turn.load())
-	{
-		return false;
-	}
-
-	m_flag1.store(true);
 	return true;
 }
@@ -24,12 +24,23 @@
 #ifndef DEKKAR_LOCK_H_
 #define DEKKAR_LOCK_H_
 
+#include <libsmipc/ring-buffer/wait-strategy.hpp>
+
 #include <atomic>
+#include <cstdint>
 
+/**
+ * Dekker's mutual exclusion between exactly two parties.
+ *
+ * Both parties share `turn`, each one passes the value of `turn` that gives it
+ * priority, so the two sides must pass opposite values. Waiting for the peer
+ * follows the given wait strategy. If a spin counter is given, every wait for
+ * the peer is added to it, the counter must only be written by this side.
+ */
 class DekkarLock
 {
 public:
-	DekkarLock(std::atomic_bool& flag1, std::atomic_bool& flag2, std::atomic_bool& turn) noexcept;
+	DekkarLock(std::atomic_bool& flag1, std::atomic_bool& flag2, std::atomic_bool& turn, bool myTurn, WaitStrategy strategy, std::atomic<uint64_t>* spinCount = nullptr) noexcept;
 	DekkarLock() = delete;
 	~DekkarLock() = default;
 	DekkarLock(const DekkarLock&) = delete;
@@ -45,6 +56,9 @@ private:
 	std::atomic_bool& m_flag1;
 	std::atomic_bool& m_flag2;
 	std::atomic_bool& m_turn;
+	bool m_myTurn;
+	WaitStrategy m_strategy;
+	std::atomic<uint64_t>* m_spinCount;
 };
 
 #endif  // DEKKAR_LOCK_H_
@@ -0,0 +1,72 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/futex.hpp>
+
+#ifdef __linux__
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+
+#	include <climits>
+#	include <ctime>
+#else
+#	include <algorithm>
+#	include <thread>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+void FutexWait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout) noexcept
+{
+#ifdef __linux__
+	// No FUTEX_PRIVATE_FLAG, the word is shared with the other process
+	auto* address = reinterpret_cast<uint32_t*>(&word);
+
+	if (timeout == std::chrono::nanoseconds::max())
+	{
+		syscall(SYS_futex, address, FUTEX_WAIT, expected, nullptr, nullptr, 0);
+		return;
+	}
+
+	const auto seconds {std::chrono::duration_cast<std::chrono::seconds>(timeout)};
+	const timespec relative {static_cast<time_t>(seconds.count()), static_cast<long>((timeout - seconds).count())};
+	syscall(SYS_futex, address, FUTEX_WAIT, expected, &relative, nullptr, 0);
+#else
+	// There is no process-shared wait here, fall back to polling
+	if (word.load(std::memory_order_acquire) == expected)
+	{
+		std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::microseconds {100}));
+	}
+#endif
+}
+
+void FutexWake(std::atomic<uint32_t>& word) noexcept
+{
+#ifdef __linux__
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+	static_cast<void>(word);
+#endif
+}
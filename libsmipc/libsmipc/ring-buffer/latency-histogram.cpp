@@ -0,0 +1,176 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/latency-histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#		include <x86intrin.h>
+#	endif
+#	define LATENCY_CLOCK_TSC
+#endif
+
+// How long the TSC is measured against the steady clock
+static constexpr std::chrono::milliseconds kCalibrationTime {5};
+
+[[nodiscard]]
+static auto GetSteadyNanoseconds() noexcept -> uint64_t
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef LATENCY_CLOCK_TSC
+/**
+ * Only a TSC that ticks at a constant rate in every power state and on every
+ * core can be compared between the producer's and consumer's cores.
+ */
+[[nodiscard]]
+static auto HasInvariantTsc() noexcept -> bool
+{
+#	ifdef _MSC_VER
+	int info[4] {};
+	__cpuid(info, 0x80000000);
+
+	if (static_cast<unsigned int>(info[0]) < 0x80000007u)
+	{
+		return false;
+	}
+
+	__cpuid(info, 0x80000007);
+	return (info[3] & (1 << 8)) != 0;
+#	else
+	unsigned int eax {}, ebx {}, ecx {}, edx {};
+
+	if (__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0)
+	{
+		return false;
+	}
+
+	return (edx & (1u << 8u)) != 0u;
+#	endif
+}
+
+static const bool s_useTsc {HasInvariantTsc()};
+#endif
+
+[[nodiscard]]
+auto ReadLatencyClock() noexcept -> uint64_t
+{
+#ifdef LATENCY_CLOCK_TSC
+	if (s_useTsc)
+	{
+		return __rdtsc();
+	}
+#endif
+
+	return GetSteadyNanoseconds();
+}
+
+[[nodiscard]]
+auto LatencyTicksToNanoseconds(uint64_t ticks) noexcept -> uint64_t
+{
+#ifdef LATENCY_CLOCK_TSC
+	if (s_useTsc)
+	{
+		static const double nanosecondsPerTick {[]()
+			{
+				const uint64_t startNanoseconds {GetSteadyNanoseconds()};
+				const uint64_t startTicks {__rdtsc()};
+				std::this_thread::sleep_for(kCalibrationTime);
+				const uint64_t endNanoseconds {GetSteadyNanoseconds()};
+				const uint64_t endTicks {__rdtsc()};
+
+				return static_cast<double>(endNanoseconds - startNanoseconds) / static_cast<double>(std::max<uint64_t>(endTicks - startTicks, 1u));
+			}()};
+
+		return static_cast<uint64_t>(std::llround(static_cast<double>(ticks) * nanosecondsPerTick));
+	}
+#endif
+
+	return ticks;
+}
+
+[[nodiscard]]
+auto LatencySnapshot::getPercentile(double percentile) const noexcept -> std::chrono::nanoseconds
+{
+	if (count == 0u)
+	{
+		return std::chrono::nanoseconds {0};
+	}
+
+	// The smallest bucket that covers the requested share of the packets
+	const double share {std::clamp(percentile, 0.0, 100.0) / 100.0};
+	const uint64_t rank {std::max<uint64_t>(1u, static_cast<uint64_t>(std::ceil(share * static_cast<double>(count))))};
+	uint64_t seen {0u};
+
+	for (std::size_t i = 0u; i < buckets.size(); ++i)
+	{
+		seen += buckets[i];
+
+		if (seen >= rank)
+		{
+			return std::chrono::nanoseconds {LatencyTicksToNanoseconds(std::min(GetLatencyBucketUpperBound(i), maxTicks))};
+		}
+	}
+
+	return getMax();
+}
+
+[[nodiscard]]
+auto LatencySnapshot::getMax() const noexcept -> std::chrono::nanoseconds
+{
+	return std::chrono::nanoseconds {LatencyTicksToNanoseconds(maxTicks)};
+}
+
+[[nodiscard]]
+auto LatencyHistogram::snapshot() const noexcept -> LatencySnapshot
+{
+	LatencySnapshot result {};
+	result.count = count.load(std::memory_order_relaxed);
+	result.maxTicks = maxTicks.load(std::memory_order_relaxed);
+
+	for (std::size_t i = 0u; i < buckets.size(); ++i)
+	{
+		result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+	}
+
+	return result;
+}
+
+void LatencyHistogram::reset() noexcept
+{
+	for (auto& bucket : buckets)
+	{
+		bucket.store(0u, std::memory_order_relaxed);
+	}
+
+	count.store(0u, std::memory_order_relaxed);
+	maxTicks.store(0u, std::memory_order_relaxed);
+}
@@ -0,0 +1,157 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Latency tracing is compiled in with SMIPC_LATENCY_TRACING. Without it packets
+ * carry no timestamp and nothing is recorded, the histograms stay empty.
+ */
+constexpr bool IsLatencyTracingBuild()
+{
+#ifdef SMIPC_LATENCY_TRACING
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Read the clock packets are stamped with.
+ *
+ * This is the TSC on x86-64 CPUs with an invariant TSC, the steady clock in
+ * nanoseconds anywhere else. Either way the ticks are comparable between
+ * processes on the same machine.
+ */
+[[nodiscard]]
+auto ReadLatencyClock() noexcept -> uint64_t;
+
+/**
+ * Convert latency clock ticks to nanoseconds.
+ *
+ * The first call measures the TSC against the steady clock, which takes a
+ * few milliseconds. Nothing on the push or pull path calls this.
+ */
+[[nodiscard]]
+auto LatencyTicksToNanoseconds(uint64_t ticks) noexcept -> uint64_t;
+
+// Log-linear buckets, exact below 32 ticks and 16 buckets per power of two above, so a bucket is never wider than 1/16 of its values
+static constexpr uint32_t kLatencySubBucketBits {4u};
+static constexpr uint32_t kLatencyMaxBits {48u};
+static constexpr std::size_t kLatencyBucketCount {(kLatencyMaxBits - kLatencySubBucketBits + 1u) << kLatencySubBucketBits};
+
+[[nodiscard]]
+constexpr auto GetLatencyBucket(uint64_t ticks) noexcept -> std::size_t
+{
+	constexpr uint64_t kLargest {(uint64_t {1u} << kLatencyMaxBits) - 1u};
+	ticks = ticks < kLargest ? ticks : kLargest;
+
+	if (ticks < (uint64_t {2u} << kLatencySubBucketBits))
+	{
+		return static_cast<std::size_t>(ticks);
+	}
+
+	const uint32_t shift {static_cast<uint32_t>(std::bit_width(ticks)) - 1u - kLatencySubBucketBits};
+	return (static_cast<std::size_t>(shift) << kLatencySubBucketBits) + static_cast<std::size_t>(ticks >> shift);
+}
+
+/**
+ * Get the largest tick count that falls into a bucket.
+ */
+[[nodiscard]]
+constexpr auto GetLatencyBucketUpperBound(std::size_t bucket) noexcept -> uint64_t
+{
+	if (bucket < (std::size_t {2u} << kLatencySubBucketBits))
+	{
+		return bucket;
+	}
+
+	const std::size_t shift {(bucket >> kLatencySubBucketBits) - 1u};
+	const uint64_t subBucket {(bucket & ((std::size_t {1u} << kLatencySubBucketBits) - 1u)) + (std::size_t {1u} << kLatencySubBucketBits)};
+
+	return ((subBucket + 1u) << shift) - 1u;
+}
+
+/**
+ * A copy of a latency histogram, taken at one point in time.
+ */
+struct LatencySnapshot
+{
+	uint64_t count {};
+	uint64_t maxTicks {};
+	std::array<uint64_t, kLatencyBucketCount> buckets {};
+
+	/**
+	 * Get the latency that the given percentage of packets stayed under, to
+	 * the resolution of the buckets.
+	 *
+	 * @param percentile From 0 to 100, for example 99.9.
+	 * @return The latency, zero if nothing was recorded.
+	 */
+	[[nodiscard]]
+	auto getPercentile(double percentile) const noexcept -> std::chrono::nanoseconds;
+
+	[[nodiscard]]
+	auto getMax() const noexcept -> std::chrono::nanoseconds;
+};
+
+/**
+ * Enqueue to dequeue latencies of a ring buffer, kept in shared memory.
+ *
+ * Only the consumer records and resets, so every update is a plain store and
+ * anyone else may take a snapshot, which can be off by the packet being
+ * recorded at the time.
+ */
+struct LatencyHistogram
+{
+	std::atomic<uint64_t> count {};
+	std::atomic<uint64_t> maxTicks {};
+	std::array<std::atomic<uint64_t>, kLatencyBucketCount> buckets {};
+
+	void record(uint64_t ticks) noexcept
+	{
+		auto& bucket {buckets[GetLatencyBucket(ticks)]};
+		bucket.store(bucket.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+		count.store(count.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+
+		if (ticks > maxTicks.load(std::memory_order_relaxed))
+		{
+			maxTicks.store(ticks, std::memory_order_relaxed);
+		}
+	}
+
+	[[nodiscard]]
+	auto snapshot() const noexcept -> LatencySnapshot;
+
+	void reset() noexcept;
+};
+
+#endif  // LATENCY_HISTOGRAM_H_
@@ -0,0 +1,261 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/mpsc-ring-buffer.hpp>
+#include <libsmipc/ring-buffer/wait-strategy.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+static_assert(AlignedSize(kPacketHeaderSize) == kPacketHeaderSize);
+
+MpscRingBuffer::MpscRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options)
+	: m_memory {memory, size}
+	, header {reinterpret_cast<MpscRingBufferHeader*>(m_memory.data())}
+	, data {m_memory.begin() + sizeof(MpscRingBufferHeader), size - sizeof(MpscRingBufferHeader)}
+	, options {options}
+{
+	if (reinterpret_cast<uintptr_t>(memory) % kCacheLineSize != 0u)
+	{
+		throw std::invalid_argument("Memory must be 64 byte aligned");
+	}
+
+	if (size % kAlignment != 0u)
+	{
+		throw std::invalid_argument("Buffer size must be a multiple of 4");
+	}
+
+	if (size <= sizeof(MpscRingBufferHeader))
+	{
+		throw std::invalid_argument("Buffer size is too small");
+	}
+
+	if (size > 2048u * 1024u * 1024u)
+	{
+		throw std::invalid_argument("Buffer size is too large, must be less than 2GB");
+	}
+
+	// Whichever side claims the header lays it out, the others wait for it and validate it
+	const uint32_t version {ClaimRingBufferHeader(header->version)};
+
+	if (version == 0u)
+	{
+		header->capacity = getCapacity();
+		header->version.store(kMpscRingBufferVersion, std::memory_order_release);
+	}
+	else if (version != kMpscRingBufferVersion)
+	{
+		throw std::invalid_argument("Unsupported ring buffer header version");
+	}
+	else if (header->capacity != getCapacity())
+	{
+		throw std::invalid_argument("Buffer size does not match the existing ring buffer");
+	}
+}
+
+void MpscRingBuffer::copyIn(uint64_t position, std::span<const uint8_t> source) noexcept
+{
+	const uint32_t start {getOffset(position)};
+
+	if (options.mirrored)
+	{
+		std::copy_n(std::cbegin(source), source.size(), data.data() + start);
+		return;
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(source.size(), data.size() - start)};
+
+	std::copy_n(std::cbegin(source), part1Size, std::begin(data) + start);
+	std::copy_n(std::cbegin(source) + part1Size, source.size() - part1Size, std::begin(data));
+}
+
+void MpscRingBuffer::copyOut(uint64_t position, std::span<uint8_t> destination) const noexcept
+{
+	const uint32_t start {getOffset(position)};
+
+	if (options.mirrored)
+	{
+		std::copy_n(data.data() + start, destination.size(), std::begin(destination));
+		return;
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(destination.size(), data.size() - start)};
+
+	std::copy_n(std::cbegin(data) + start, part1Size, std::begin(destination));
+	std::copy_n(std::cbegin(data), destination.size() - part1Size, std::begin(destination) + part1Size);
+}
+
+void MpscRingBuffer::clear(uint64_t position, uint32_t count) noexcept
+{
+	const uint32_t start {getOffset(position)};
+
+	if (options.mirrored)
+	{
+		std::fill_n(data.data() + start, count, 0u);
+		return;
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(count, data.size() - start)};
+
+	std::fill_n(std::begin(data) + start, part1Size, 0u);
+	std::fill_n(std::begin(data), count - part1Size, 0u);
+}
+
+MpscTxRingBuffer::MpscTxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options)
+	: MpscRingBuffer {memory, size, options}
+{}
+
+void MpscTxRingBuffer::push(const Packet& packet)
+{
+	// If the data size is 0, there is nothing to do
+	if (packet.data.size() == 0)
+	{
+		return;
+	}
+
+	if (! fitsInCapacity(packet.data.size()))
+	{
+		throw std::overflow_error("Buffer overflow");
+	}
+
+	const uint64_t packetSize {kPacketHeaderSize + AlignedSize(static_cast<uint32_t>(packet.data.size()))};
+	const uint64_t position {header->reserve.fetch_add(packetSize, std::memory_order_relaxed)};
+
+	// The claim may run ahead of the consumer, wait until it has freed the space
+	Waiter waiter {options.waitStrategy};
+
+	while (position + packetSize - header->front.load(std::memory_order_acquire) > getCapacity())
+	{
+		waiter.wait();
+	}
+
+	write(position, packet);
+}
+
+[[nodiscard]]
+auto MpscTxRingBuffer::tryPush(const Packet& packet) noexcept -> RingBufferStatus
+{
+	// If the data size is 0, there is nothing to do
+	if (packet.data.size() == 0)
+	{
+		return RingBufferStatus::Ok;
+	}
+
+	if (! fitsInCapacity(packet.data.size()))
+	{
+		return RingBufferStatus::TooLarge;
+	}
+
+	const uint64_t packetSize {kPacketHeaderSize + AlignedSize(static_cast<uint32_t>(packet.data.size()))};
+	uint64_t position {header->reserve.load(std::memory_order_relaxed)};
+
+	do
+	{
+		if (position + packetSize - header->front.load(std::memory_order_acquire) > getCapacity())
+		{
+			return RingBufferStatus::Full;
+		}
+	}
+	while (! header->reserve.compare_exchange_weak(position, position + packetSize, std::memory_order_relaxed));
+
+	write(position, packet);
+
+	return RingBufferStatus::Ok;
+}
+
+[[nodiscard]]
+auto MpscTxRingBuffer::fitsInCapacity(std::size_t dataSize) const noexcept -> bool
+{
+	return dataSize <= getCapacity() && kPacketHeaderSize + AlignedSize(static_cast<uint32_t>(dataSize)) <= getCapacity();
+}
+
+void MpscTxRingBuffer::write(uint64_t position, const Packet& packet) noexcept
+{
+	const uint32_t dataSize {static_cast<uint32_t>(packet.data.size())};
+
+	PacketHeader tmpHeader {packet.header};
+	tmpHeader.size = dataSize;
+	copyIn(position, {reinterpret_cast<const uint8_t*>(&tmpHeader), kPacketHeaderSize});
+	copyIn(position + kPacketHeaderSize, packet.data);
+
+	// Commits happen in claim order, so wait for every earlier producer to finish
+	Waiter waiter {options.waitStrategy};
+
+	while (header->commit.load(std::memory_order_acquire) != position)
+	{
+		waiter.wait();
+	}
+
+	header->commit.store(position + kPacketHeaderSize + AlignedSize(dataSize), std::memory_order_release);
+}
+
+MpscRxRingBuffer::MpscRxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options)
+	: MpscRingBuffer {memory, size, options}
+{}
+
+[[nodiscard]]
+auto MpscRxRingBuffer::isEmpty() const noexcept -> bool
+{
+	return header->front.load(std::memory_order_relaxed) == header->commit.load(std::memory_order_acquire);
+}
+
+[[nodiscard]]
+auto MpscRxRingBuffer::pull() -> Packet
+{
+	Packet packet;
+
+	if (tryPull(packet) != RingBufferStatus::Ok)
+	{
+		throw std::runtime_error("No packets in buffer");
+	}
+
+	return packet;
+}
+
+[[nodiscard]]
+auto MpscRxRingBuffer::tryPull(Packet& packet) -> RingBufferStatus
+{
+	// The read cursor is ours, only committed packets are visible
+	const uint64_t position {header->front.load(std::memory_order_relaxed)};
+
+	if (position == header->commit.load(std::memory_order_acquire))
+	{
+		return RingBufferStatus::Empty;
+	}
+
+	copyOut(position, {reinterpret_cast<uint8_t*>(&packet.header), kPacketHeaderSize});
+	packet.data.resize(packet.header.size);
+	copyOut(position + kPacketHeaderSize, packet.data);
+
+	const uint32_t packetSize {kPacketHeaderSize + AlignedSize(packet.header.size)};
+
+	if constexpr (IsDebugBuild())
+	{
+		clear(position, packetSize);
+	}
+
+	// Publishing the read cursor hands the space back to the producers
+	header->front.store(position + packetSize, std::memory_order_release);
+
+	return RingBufferStatus::Ok;
+}
@@ -0,0 +1,182 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MPSC_RING_BUFFER_H_
+#define MPSC_RING_BUFFER_H_
+
+#include <libsmipc/ring-buffer/packet.hpp>
+#include <libsmipc/ring-buffer/ring-buffer.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+// Different from kRingBufferVersion, so opening a ring with the wrong type fails
+static constexpr uint32_t kMpscRingBufferVersion {0x4D500001u};
+
+/**
+ * A ring buffer any number of producers, threads or processes, can push into
+ * while a single consumer pulls from it. Nothing is locked.
+ *
+ * Producers claim space by adding the packet size to the shared reservation
+ * cursor, copy the packet in, then wait until every earlier claim has been
+ * committed before moving the commit cursor past their own. The consumer only
+ * ever reads up to the commit cursor, so it never sees a half written packet
+ * or a gap. Cursors are 64 bit byte positions that never wrap.
+ */
+class MpscRingBuffer
+{
+public:
+	struct MpscRingBufferHeader
+	{
+		// Written once on initialisation
+		alignas(kCacheLineSize) std::atomic<uint32_t> version {};
+		uint32_t capacity {};
+
+		// Shared by the producers
+		alignas(kCacheLineSize) std::atomic<uint64_t> reserve {};
+		alignas(kCacheLineSize) std::atomic<uint64_t> commit {};
+
+		// Only written by the consumer
+		alignas(kCacheLineSize) std::atomic<uint64_t> front {};
+	};
+
+	static_assert(sizeof(MpscRingBufferHeader) % kCacheLineSize == 0u);
+	static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+	MpscRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options = {});
+	~MpscRingBuffer() = default;
+
+	[[nodiscard]]
+	auto getMemoryBlockSize() const noexcept -> uint32_t
+	{
+		return static_cast<uint32_t>(m_memory.size());
+	}
+
+	[[nodiscard]]
+	auto getCapacity() const noexcept -> uint32_t
+	{
+		return static_cast<uint32_t>(data.size());
+	}
+
+	/**
+	 * Get the size of the memory block needed for a given data capacity.
+	 *
+	 * @param capacity The number of bytes available to packets.
+	 * @return The capacity plus the header overhead.
+	 */
+	[[nodiscard]]
+	static constexpr auto GetMemoryBlockSize(std::size_t capacity) noexcept -> std::size_t
+	{
+		return sizeof(MpscRingBufferHeader) + capacity;
+	}
+
+private:
+	std::span<uint8_t> m_memory {};
+
+protected:
+	[[nodiscard]]
+	auto getOffset(uint64_t position) const noexcept -> uint32_t
+	{
+		return static_cast<uint32_t>(position % getCapacity());
+	}
+
+	void copyIn(uint64_t position, std::span<const uint8_t> source) noexcept;
+	void copyOut(uint64_t position, std::span<uint8_t> destination) const noexcept;
+	void clear(uint64_t position, uint32_t count) noexcept;
+
+	MpscRingBufferHeader* header {};
+	std::span<uint8_t> data {};
+	RingBufferOptions options {};
+};
+
+class MpscTxRingBuffer: public MpscRingBuffer
+{
+public:
+	MpscTxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options = {});
+	~MpscTxRingBuffer() = default;
+
+	/**
+	 * Push a packet, waiting for space if the buffer is full.
+	 *
+	 * The space is claimed with a single fetch-add. A claim cannot be given
+	 * back, so instead of failing on a full buffer this waits for the consumer
+	 * to make room, following the wait strategy.
+	 *
+	 * @param packet The packet to push, empty packets are skipped.
+	 * @throws std::overflow_error if the packet can never fit in the buffer.
+	 */
+	void push(const Packet& packet);
+
+	/**
+	 * Push a packet only if there is room for it right now.
+	 *
+	 * The space is claimed with a compare-exchange that checks the free space,
+	 * so a full buffer is reported rather than waited on.
+	 *
+	 * @param packet The packet to push, empty packets are skipped.
+	 * @return Ok once pushed, Full if there is not enough free space, TooLarge
+	 * if the packet can never fit.
+	 */
+	[[nodiscard]]
+	auto tryPush(const Packet& packet) noexcept -> RingBufferStatus;
+
+private:
+	[[nodiscard]]
+	auto fitsInCapacity(std::size_t dataSize) const noexcept -> bool;
+
+	/**
+	 * Write a packet into claimed space and commit it after every earlier claim.
+	 */
+	void write(uint64_t position, const Packet& packet) noexcept;
+};
+
+class MpscRxRingBuffer: private MpscRingBuffer
+{
+public:
+	MpscRxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options = {});
+	~MpscRxRingBuffer() = default;
+
+	using MpscRingBuffer::getCapacity;
+	using MpscRingBuffer::getMemoryBlockSize;
+
+	[[nodiscard]]
+	auto isEmpty() const noexcept -> bool;
+
+	/**
+	 * @throws std::runtime_error if the buffer is empty.
+	 */
+	[[nodiscard]]
+	auto pull() -> Packet;
+
+	/**
+	 * Pull a packet without throwing when the buffer is empty, reusing the
+	 * storage of `packet`.
+	 *
+	 * @return Ok once pulled, Empty if there is nothing committed to pull.
+	 */
+	[[nodiscard]]
+	auto tryPull(Packet& packet) -> RingBufferStatus;
+};
+
+#endif  // MPSC_RING_BUFFER_H_
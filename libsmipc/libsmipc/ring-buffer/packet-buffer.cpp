@@ -0,0 +1,271 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/packet-buffer.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+// Blocks above the largest class are not kept, they would pin a lot of memory
+static constexpr std::size_t kMinPooledShift {7u};
+static constexpr std::size_t kMaxPooledShift {std::bit_width(kPacketPoolCapacity) - 1u};
+static constexpr std::size_t kMaxPooledBlocks {32u};
+
+// Trivially destructible, so still readable while other thread locals are destroyed
+thread_local bool t_poolDestroyed {false};
+
+class ThreadPacketBufferPool
+{
+public:
+	ThreadPacketBufferPool()
+	{
+		// Reserving up front keeps release from allocating, or throwing
+		for (auto& blocks : m_freeLists)
+		{
+			blocks.reserve(kMaxPooledBlocks);
+		}
+	}
+
+	~ThreadPacketBufferPool()
+	{
+		trim();
+		t_poolDestroyed = true;
+	}
+
+	[[nodiscard]]
+	auto acquire(std::size_t size) -> PacketBufferPool::Block
+	{
+		const std::size_t shift {GetShift(size)};
+
+		if (shift <= kMaxPooledShift)
+		{
+			auto& blocks {m_freeLists[shift - kMinPooledShift]};
+
+			if (! blocks.empty())
+			{
+				const auto block {blocks.back()};
+				blocks.pop_back();
+				m_pooledSize -= block.capacity;
+				return block;
+			}
+		}
+
+		const std::size_t capacity {std::size_t {1u} << shift};
+		return {new uint8_t[capacity], capacity};
+	}
+
+	void release(PacketBufferPool::Block block) noexcept
+	{
+		const std::size_t shift {GetShift(block.capacity)};
+
+		if (shift <= kMaxPooledShift)
+		{
+			auto& blocks {m_freeLists[shift - kMinPooledShift]};
+
+			if (blocks.size() < kMaxPooledBlocks && m_pooledSize + block.capacity <= kPacketPoolCapacity)
+			{
+				blocks.push_back(block);
+				m_pooledSize += block.capacity;
+				return;
+			}
+		}
+
+		delete[] block.data;
+	}
+
+	void trim() noexcept
+	{
+		for (auto& blocks : m_freeLists)
+		{
+			for (const auto& block : blocks)
+			{
+				delete[] block.data;
+			}
+
+			blocks.clear();
+		}
+
+		m_pooledSize = 0u;
+	}
+
+	[[nodiscard]]
+	auto getPooledSize() const noexcept -> std::size_t
+	{
+		return m_pooledSize;
+	}
+
+private:
+	[[nodiscard]]
+	static auto GetShift(std::size_t size) noexcept -> std::size_t
+	{
+		return std::max<std::size_t>(kMinPooledShift, std::bit_width(size - 1u));
+	}
+
+	std::array<std::vector<PacketBufferPool::Block>, kMaxPooledShift - kMinPooledShift + 1u> m_freeLists {};
+	std::size_t m_pooledSize {0u};
+};
+
+static auto GetThreadPool() -> ThreadPacketBufferPool&
+{
+	thread_local ThreadPacketBufferPool pool {};
+	return pool;
+}
+
+[[nodiscard]]
+auto PacketBufferPool::Acquire(std::size_t size) -> Block
+{
+	if (t_poolDestroyed)
+	{
+		const std::size_t capacity {std::bit_ceil(size)};
+		return {new uint8_t[capacity], capacity};
+	}
+
+	return GetThreadPool().acquire(size);
+}
+
+void PacketBufferPool::Release(Block block) noexcept
+{
+	// Packets outliving the pool, in other thread locals or statics, free their blocks directly
+	if (t_poolDestroyed)
+	{
+		delete[] block.data;
+		return;
+	}
+
+	GetThreadPool().release(block);
+}
+
+void PacketBufferPool::Trim() noexcept
+{
+	if (! t_poolDestroyed)
+	{
+		GetThreadPool().trim();
+	}
+}
+
+[[nodiscard]]
+auto PacketBufferPool::GetPooledSize() noexcept -> std::size_t
+{
+	return t_poolDestroyed ? 0u : GetThreadPool().getPooledSize();
+}
+
+PacketBuffer::PacketBuffer(std::span<const uint8_t> bytes)
+{
+	resize(bytes.size());
+	std::copy(bytes.begin(), bytes.end(), data());
+}
+
+PacketBuffer::PacketBuffer(const PacketBuffer& other)
+	: PacketBuffer {std::span<const uint8_t> {other}}
+{}
+
+PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept
+	: m_heap {other.m_heap}
+	, m_size {other.m_size}
+{
+	if (other.isInline())
+	{
+		std::copy_n(other.m_inline.data(), m_size, m_inline.data());
+	}
+
+	other.m_heap = {};
+	other.m_size = 0u;
+}
+
+PacketBuffer::~PacketBuffer()
+{
+	releaseHeap();
+}
+
+auto PacketBuffer::operator=(const PacketBuffer& other) -> PacketBuffer&
+{
+	if (this != &other)
+	{
+		resize(other.size());
+		std::copy(other.begin(), other.end(), data());
+	}
+
+	return *this;
+}
+
+auto PacketBuffer::operator=(PacketBuffer&& other) noexcept -> PacketBuffer&
+{
+	if (this != &other)
+	{
+		releaseHeap();
+
+		m_heap = other.m_heap;
+		m_size = other.m_size;
+
+		if (other.isInline())
+		{
+			std::copy_n(other.m_inline.data(), m_size, m_inline.data());
+		}
+
+		other.m_heap = {};
+		other.m_size = 0u;
+	}
+
+	return *this;
+}
+
+void PacketBuffer::reserve(std::size_t size)
+{
+	if (size <= capacity())
+	{
+		return;
+	}
+
+	const auto block {PacketBufferPool::Acquire(size)};
+	std::copy_n(data(), m_size, block.data);
+
+	if (! isInline())
+	{
+		PacketBufferPool::Release(m_heap);
+	}
+
+	m_heap = block;
+}
+
+void PacketBuffer::resize(std::size_t size)
+{
+	reserve(size);
+	m_size = size;
+}
+
+void PacketBuffer::releaseHeap() noexcept
+{
+	if (! isInline())
+	{
+		PacketBufferPool::Release(m_heap);
+		m_heap = {};
+	}
+
+	m_size = 0u;
+}
+
+auto operator==(const PacketBuffer& lhs, std::span<const uint8_t> rhs) noexcept -> bool
+{
+	return std::ranges::equal(lhs, rhs);
+}
@@ -0,0 +1,181 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PACKET_BUFFER_H_
+#define PACKET_BUFFER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Payloads up to this size live inside the packet itself
+static constexpr std::size_t kPacketInlineCapacity {64u};
+// The most free block bytes a thread's PacketBufferPool holds on to, the rest go back to the heap
+static constexpr std::size_t kPacketPoolCapacity {4u * 1024u * 1024u};
+
+/**
+ * A recycling allocator for packet payloads that do not fit inline.
+ *
+ * Blocks are rounded up to a power of two and kept on a per size free list
+ * when released, so a steady stream of similarly sized packets stops hitting
+ * the heap after the first few. Each thread has its own pool, a block released
+ * on another thread simply joins that thread's pool. A pool keeps at most
+ * kPacketPoolCapacity bytes, so a burst of large packets does not stay pinned
+ * to the thread.
+ */
+class PacketBufferPool
+{
+public:
+	struct Block
+	{
+		uint8_t* data {};
+		std::size_t capacity {};
+	};
+
+	/**
+	 * @param size The minimum number of bytes needed.
+	 * @return A block of at least size bytes.
+	 */
+	[[nodiscard]]
+	static auto Acquire(std::size_t size) -> Block;
+
+	static void Release(Block block) noexcept;
+
+	/**
+	 * Free every block held by the calling thread's pool.
+	 */
+	static void Trim() noexcept;
+
+	/**
+	 * Get how many bytes of free blocks the calling thread's pool holds.
+	 */
+	[[nodiscard]]
+	static auto GetPooledSize() noexcept -> std::size_t;
+};
+
+/**
+ * Contiguous byte storage for a packet payload.
+ *
+ * Behaves like the subset of std::vector<uint8_t> the ring buffers need, but
+ * keeps small payloads inline and takes larger ones from the PacketBufferPool,
+ * so moving packets through a ring does not allocate in steady state. Unlike
+ * std::vector, growing with resize() leaves the new bytes uninitialised, the
+ * ring buffers always overwrite them.
+ */
+class PacketBuffer
+{
+public:
+	using value_type = uint8_t;
+	using iterator = uint8_t*;
+	using const_iterator = const uint8_t*;
+
+	PacketBuffer() = default;
+	PacketBuffer(std::span<const uint8_t> bytes);
+	PacketBuffer(const PacketBuffer& other);
+	PacketBuffer(PacketBuffer&& other) noexcept;
+	~PacketBuffer();
+
+	auto operator=(const PacketBuffer& other) -> PacketBuffer&;
+	auto operator=(PacketBuffer&& other) noexcept -> PacketBuffer&;
+
+	[[nodiscard]]
+	auto data() noexcept -> uint8_t*
+	{
+		return m_heap.data != nullptr ? m_heap.data : m_inline.data();
+	}
+
+	[[nodiscard]]
+	auto data() const noexcept -> const uint8_t*
+	{
+		return m_heap.data != nullptr ? m_heap.data : m_inline.data();
+	}
+
+	[[nodiscard]]
+	auto size() const noexcept -> std::size_t
+	{
+		return m_size;
+	}
+
+	[[nodiscard]]
+	auto capacity() const noexcept -> std::size_t
+	{
+		return m_heap.data != nullptr ? m_heap.capacity : kPacketInlineCapacity;
+	}
+
+	[[nodiscard]]
+	auto empty() const noexcept -> bool
+	{
+		return m_size == 0u;
+	}
+
+	[[nodiscard]]
+	auto isInline() const noexcept -> bool
+	{
+		return m_heap.data == nullptr;
+	}
+
+	auto begin() noexcept -> iterator { return data(); }
+	auto end() noexcept -> iterator { return data() + m_size; }
+	auto begin() const noexcept -> const_iterator { return data(); }
+	auto end() const noexcept -> const_iterator { return data() + m_size; }
+
+	auto operator[](std::size_t index) noexcept -> uint8_t& { return data()[index]; }
+	auto operator[](std::size_t index) const noexcept -> const uint8_t& { return data()[index]; }
+
+	/**
+	 * Make room for at least size bytes, keeping the current contents.
+	 */
+	void reserve(std::size_t size);
+
+	/**
+	 * Change the size, keeping the current contents and storage where possible.
+	 */
+	void resize(std::size_t size);
+
+	void clear() noexcept
+	{
+		m_size = 0u;
+	}
+
+	friend auto operator==(const PacketBuffer& lhs, std::span<const uint8_t> rhs) noexcept -> bool;
+
+	friend auto operator==(const PacketBuffer& lhs, const PacketBuffer& rhs) noexcept -> bool
+	{
+		return lhs == std::span<const uint8_t> {rhs};
+	}
+
+private:
+	/**
+	 * Hand heap storage back to the pool, dropping the contents.
+	 */
+	void releaseHeap() noexcept;
+
+	PacketBufferPool::Block m_heap {};
+	std::size_t m_size {};
+
+	// Left uninitialised, only the first m_size bytes are ever read
+	alignas(8) std::array<uint8_t, kPacketInlineCapacity> m_inline;
+};
+
+#endif  // PACKET_BUFFER_H_
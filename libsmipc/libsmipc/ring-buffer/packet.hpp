@@ -24,6 +24,9 @@
 #ifndef PACKET_H_
 #define PACKET_H_
 
+#include <libsmipc/ring-buffer/latency-histogram.hpp>
+#include <libsmipc/ring-buffer/packet-buffer.hpp>
+
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
@@ -45,18 +48,26 @@ struct PacketHeader
 	uint32_t packetId {};
 	uint32_t packetCount {};
 	uint32_t transferId {};
+#ifdef SMIPC_LATENCY_TRACING
+	// Latency clock reading taken when the packet was pushed
+	uint64_t timestamp {};
+#endif
 };
 
+// Packet headers are stored in the ring buffer as is, in front of the payload
+constexpr uint32_t kPacketHeaderSize {static_cast<uint32_t>(sizeof(PacketHeader))};
+
+// The largest payload one packet can carry, larger messages are split by the pipes
+constexpr uint32_t kMaxPacketSize {0x80000000u};
+
 struct Packet
 {
 	Packet() = default;
 
 	Packet(std::span<const uint8_t> data)
 		: header {0, static_cast<uint32_t>(data.size()), 0, 0, MakeTransferId()}
-	{
-		this->data.reserve(data.size());
-		std::copy(data.begin(), data.end(), std::back_inserter(this->data));
-	}
+		, data {data}
+	{}
 
 	void print() const
 	{
@@ -81,7 +92,7 @@ struct Packet
 	*/
 
 	PacketHeader header {};
-	std::vector<uint8_t> data {};
+	PacketBuffer data {};
 };
 
 #endif  // PACKET_H_
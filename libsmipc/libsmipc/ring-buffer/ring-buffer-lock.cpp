@@ -0,0 +1,104 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/ring-buffer-lock.hpp>
+
+[[nodiscard]]
+static auto GetSpinCount(RingBuffer::RingBufferHeader& header, bool producer, const RingBufferOptions& options) noexcept -> std::atomic<uint64_t>*
+{
+	if (! options.statistics)
+	{
+		return nullptr;
+	}
+
+	return producer ? &header.txLockSpins : &header.rxLockSpins;
+}
+
+RingBufferLock::RingBufferLock(RingBuffer::RingBufferHeader& header, bool producer, const RingBufferOptions& options) noexcept
+	: m_policy {options.lockPolicy}
+	, m_dekkarLock {producer ? header.txWaiting : header.rxWaiting, producer ? header.rxWaiting : header.txWaiting, header.turn, ! producer, options.waitStrategy, GetSpinCount(header, producer, options)}
+	, m_spinLock {header.spinLock, options.waitStrategy, GetSpinCount(header, producer, options)}
+	, m_ticketLock {header.ticketNext, header.ticketServing, options.waitStrategy, GetSpinCount(header, producer, options)}
+#ifdef __linux__
+	, m_mutex {header.mutex, GetSpinCount(header, producer, options)}
+#endif
+{}
+
+void RingBufferLock::lock() noexcept
+{
+	switch (m_policy)
+	{
+	case LockPolicy::TestAndTestAndSet:
+		m_spinLock.lock();
+		break;
+	case LockPolicy::Ticket:
+		m_ticketLock.lock();
+		break;
+#ifdef __linux__
+	case LockPolicy::RobustMutex:
+		m_mutex.lock();
+		break;
+#endif
+	default:
+		m_dekkarLock.lock();
+		break;
+	}
+}
+
+void RingBufferLock::unlock() noexcept
+{
+	switch (m_policy)
+	{
+	case LockPolicy::TestAndTestAndSet:
+		m_spinLock.unlock();
+		break;
+	case LockPolicy::Ticket:
+		m_ticketLock.unlock();
+		break;
+#ifdef __linux__
+	case LockPolicy::RobustMutex:
+		m_mutex.unlock();
+		break;
+#endif
+	default:
+		m_dekkarLock.unlock();
+		break;
+	}
+}
+
+bool RingBufferLock::tryLock() noexcept
+{
+	switch (m_policy)
+	{
+	case LockPolicy::TestAndTestAndSet:
+		return m_spinLock.tryLock();
+	case LockPolicy::Ticket:
+		return m_ticketLock.tryLock();
+#ifdef __linux__
+	case LockPolicy::RobustMutex:
+		return m_mutex.tryLock();
+#endif
+	default:
+		return m_dekkarLock.tryLock();
+	}
+}
@@ -0,0 +1,58 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RING_BUFFER_LOCK_H_
+#define RING_BUFFER_LOCK_H_
+
+#include <libsmipc/ring-buffer/atomic-spin-lock.hpp>
+#include <libsmipc/ring-buffer/dekkar-lock.hpp>
+#include <libsmipc/ring-buffer/ring-buffer.hpp>
+#include <libsmipc/ring-buffer/robust-mutex.hpp>
+#include <libsmipc/ring-buffer/ticket-lock.hpp>
+
+/**
+ * The lock one side of a ring buffer takes in Locked mode, as picked by the
+ * lock policy in its options. The lock state lives in the ring buffer header.
+ */
+class RingBufferLock
+{
+public:
+	RingBufferLock(RingBuffer::RingBufferHeader& header, bool producer, const RingBufferOptions& options) noexcept;
+	RingBufferLock(const RingBufferLock&) = delete;
+	RingBufferLock& operator=(const RingBufferLock&) = delete;
+
+	void lock() noexcept;
+	void unlock() noexcept;
+	bool tryLock() noexcept;
+
+private:
+	LockPolicy m_policy;
+	DekkarLock m_dekkarLock;
+	AtomicSpinLock m_spinLock;
+	TicketLock m_ticketLock;
+#ifdef __linux__
+	RobustMutex m_mutex;
+#endif
+};
+
+#endif  // RING_BUFFER_LOCK_H_
@@ -21,18 +21,62 @@
  * SOFTWARE.
  */
 
+#include <libsmipc/ring-buffer/broadcast-ring-buffer.hpp>
+#include <libsmipc/ring-buffer/mpsc-ring-buffer.hpp>
 #include <libsmipc/ring-buffer/rx-ring-buffer.hpp>
 #include <libsmipc/ring-buffer/tx-ring-buffer.hpp>
+#include <libsmipc/shared-memory/shared-memory-factory.hpp>
+#include <libsmipc/shared-memory/shared-memory-pipe.hpp>
 
 #include <benchmark/benchmark.h>
 
-static void BM_push_pop_1(benchmark::State& state)
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Heap allocations are only counted while BM_push_pull_allocations runs, the other benchmarks pay a relaxed load.
+// The replacements stay out of line, once inlined GCC pairs malloc with operator delete and warns.
+static std::atomic_bool s_countAllocations {false};
+static std::atomic<std::size_t> s_allocationCount {0u};
+
+[[gnu::noinline]] auto operator new(std::size_t size) -> void*
 {
-	constexpr std::size_t kSize = 1024;
-	uint8_t buffer[kSize] {};
+	if (s_countAllocations.load(std::memory_order_relaxed))
+	{
+		s_allocationCount.fetch_add(1u, std::memory_order_relaxed);
+	}
 
-	TxRingBuffer tx(buffer, kSize);
-	RxRingBuffer rx(buffer, kSize);
+	if (void* memory = std::malloc(size))
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+static void BM_push_pop_1(benchmark::State& state, RingBufferMode mode)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
 
 	Packet packet {
 		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
@@ -47,13 +91,13 @@ static void BM_push_pop_1(benchmark::State& state)
 	}
 }
 
-static void BM_push_pop_4(benchmark::State& state)
+static void BM_push_pop_4(benchmark::State& state, RingBufferMode mode)
 {
-	constexpr std::size_t kSize = 1024;
-	uint8_t buffer[kSize] {};
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
 
-	TxRingBuffer tx(buffer, kSize);
-	RxRingBuffer rx(buffer, kSize);
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
 
 	Packet packet {
 		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
@@ -78,7 +122,958 @@ static void BM_push_pop_4(benchmark::State& state)
 	}
 }
 
-BENCHMARK(BM_push_pop_1);
-BENCHMARK(BM_push_pop_4);
+/**
+ * Producer and consumer on separate threads, so every cursor update has to
+ * travel between cores. Measures sustained cross-core throughput.
+ */
+static void BM_two_thread_push_pop(benchmark::State& state, RingBufferMode mode)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
+
+	const Packet packet {
+		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+    };
+
+	const auto packetCount {state.max_iterations};
+
+	std::thread producer([&tx, &packet, packetCount]()
+		{
+			for (benchmark::IterationCount i = 0; i < packetCount; ++i)
+			{
+				while (true)
+				{
+					try
+					{
+						tx.push(packet);
+						break;
+					}
+					catch (const std::overflow_error&)
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+		});
+
+	for (auto _ : state)
+	{
+		while (rx.isEmpty())
+		{
+			std::this_thread::yield();
+		}
+
+		auto p1 = rx.pull();
+		benchmark::DoNotOptimize(p1);
+	}
+
+	producer.join();
+	state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Producer and consumer contending for a small locked ring with the blocking
+ * push and pull, so every wait goes through the wait strategy: the Dekker
+ * lock spins with it and a full or empty buffer spins with it before parking.
+ */
+static void BM_two_thread_contended(benchmark::State& state, WaitStrategy strategy)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	constexpr auto kForever {std::chrono::nanoseconds::max()};
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	const RingBufferOptions options {.mode = RingBufferMode::Locked, .waitStrategy = strategy};
+	TxRingBuffer tx(buffer, kSize, options);
+	RxRingBuffer rx(buffer, kSize, options);
+
+	const Packet packet {
+		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+    };
+
+	const auto packetCount {state.max_iterations};
+
+	std::thread producer([&tx, &packet, packetCount, kForever]()
+		{
+			for (benchmark::IterationCount i = 0; i < packetCount; ++i)
+			{
+				static_cast<void>(tx.push(packet, kForever));
+			}
+		});
+
+	for (auto _ : state)
+	{
+		auto p1 = rx.pull(kForever);
+		benchmark::DoNotOptimize(p1);
+	}
+
+	producer.join();
+	state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * The contended two thread stream under each lock policy, with every push and
+ * pull taking the lock while the other side is hammering it.
+ */
+static void BM_lock_policy_threads(benchmark::State& state, LockPolicy policy)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	constexpr auto kForever {std::chrono::nanoseconds::max()};
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	const RingBufferOptions options {.mode = RingBufferMode::Locked, .lockPolicy = policy};
+	TxRingBuffer tx(buffer, kSize, options);
+	RxRingBuffer rx(buffer, kSize, options);
+
+	const Packet packet {
+		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+    };
+
+	const auto packetCount {state.max_iterations};
+
+	std::thread producer([&tx, &packet, packetCount, kForever]()
+		{
+			for (benchmark::IterationCount i = 0; i < packetCount; ++i)
+			{
+				static_cast<void>(tx.push(packet, kForever));
+			}
+		});
+
+	for (auto _ : state)
+	{
+		auto p1 = rx.pull(kForever);
+		benchmark::DoNotOptimize(p1);
+	}
+
+	producer.join();
+	state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Several producer threads pushing into one MPSC ring while the benchmark
+ * thread consumes. Each producer sends its share of the iterations, so the
+ * time per item shows how claiming and in-order commits scale with producers.
+ */
+static void BM_mpsc_producers(benchmark::State& state)
+{
+	constexpr std::size_t kSize = MpscRingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	MpscRxRingBuffer rx(buffer, kSize);
+
+	const Packet packet {
+		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+    };
+
+	const auto producerCount {state.range(0)};
+	const auto packetCount {state.max_iterations};
+	std::vector<std::thread> producers;
+
+	for (int64_t id = 0; id < producerCount; ++id)
+	{
+		// The first producer also sends the remainder
+		const auto share {packetCount / producerCount + (id == 0 ? packetCount % producerCount : 0)};
+
+		producers.emplace_back([&packet, share]()
+			{
+				MpscTxRingBuffer tx(buffer, kSize);
+
+				for (benchmark::IterationCount i = 0; i < share; ++i)
+				{
+					tx.push(packet);
+				}
+			});
+	}
+
+	Packet p1;
+
+	for (auto _ : state)
+	{
+		while (rx.tryPull(p1) != RingBufferStatus::Ok)
+		{
+			std::this_thread::yield();
+		}
+
+		benchmark::DoNotOptimize(p1);
+	}
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Notifying N clients through one single-producer ring each, the writer pays
+ * one copy per client. Rings are emptied outside the timed region when full.
+ */
+static void BM_fan_out_unicast(benchmark::State& state)
+{
+	constexpr std::size_t kRingSize = RingBuffer::GetMemoryBlockSize(4096u);
+	constexpr std::size_t kMaxClients {200u};
+	alignas(kCacheLineSize) static uint8_t buffer[kMaxClients * kRingSize] {};
+	std::fill_n(buffer, sizeof(buffer), 0u);
+
+	const auto clientCount {static_cast<std::size_t>(state.range(0))};
+	std::vector<std::unique_ptr<TxRingBuffer>> txs;
+	std::vector<std::unique_ptr<RxRingBuffer>> rxs;
+
+	for (std::size_t i = 0u; i < clientCount; ++i)
+	{
+		txs.push_back(std::make_unique<TxRingBuffer>(buffer + i * kRingSize, kRingSize, RingBufferMode::LockFree));
+		rxs.push_back(std::make_unique<RxRingBuffer>(buffer + i * kRingSize, kRingSize, RingBufferMode::LockFree));
+	}
+
+	const Packet packet {std::vector<uint8_t>(64u, 0x5Au)};
+
+	for (auto _ : state)
+	{
+		// Every ring holds the same packets, so they all fill up together
+		if (txs.front()->tryPush(packet) == RingBufferStatus::Full)
+		{
+			state.PauseTiming();
+
+			for (auto& rx : rxs)
+			{
+				rx->drain([](const PacketView&) {});
+			}
+
+			state.ResumeTiming();
+			benchmark::DoNotOptimize(txs.front()->tryPush(packet));
+		}
+
+		for (std::size_t i = 1u; i < clientCount; ++i)
+		{
+			benchmark::DoNotOptimize(txs[i]->tryPush(packet));
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * The same notifications through one broadcast ring, the writer pays one copy
+ * however many clients subscribe.
+ */
+static void BM_fan_out_broadcast(benchmark::State& state)
+{
+	constexpr std::size_t kSize = BroadcastRingBuffer::GetMemoryBlockSize(4096u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	BroadcastTxRingBuffer tx(buffer, kSize);
+	std::vector<std::unique_ptr<BroadcastRxRingBuffer>> rxs;
+
+	for (int64_t i = 0; i < state.range(0); ++i)
+	{
+		rxs.push_back(std::make_unique<BroadcastRxRingBuffer>(buffer, kSize));
+	}
+
+	const Packet packet {std::vector<uint8_t>(64u, 0x5Au)};
+
+	for (auto _ : state)
+	{
+		tx.push(packet);
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * A packet built from a payload, pushed and pulled, reporting how many heap
+ * allocations each message costs once the loop is running.
+ */
+static void BM_push_pull_allocations(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, kSize, RingBufferMode::LockFree);
+
+	const std::vector<uint8_t> payload(static_cast<std::size_t>(state.range(0)), 0x5Au);
+	s_allocationCount.store(0u, std::memory_order_relaxed);
+	s_countAllocations.store(true, std::memory_order_relaxed);
+
+	for (auto _ : state)
+	{
+		tx.push(Packet {payload});
+		auto p1 = rx.pull();
+
+		benchmark::DoNotOptimize(p1);
+	}
+
+	s_countAllocations.store(false, std::memory_order_relaxed);
+
+	const auto allocations {static_cast<double>(s_allocationCount.load(std::memory_order_relaxed))};
+	state.counters["allocs_per_item"] = benchmark::Counter(allocations / static_cast<double>(state.iterations()));
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Pushing into a full ring, the backpressure case: push reports it by
+ * throwing, tryPush by returning a status.
+ */
+static void BM_push_full(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+
+	const Packet packet {std::vector<uint8_t>(16u, 0x5Au)};
+
+	while (tx.tryPush(packet) == RingBufferStatus::Ok);
+
+	for (auto _ : state)
+	{
+		try
+		{
+			tx.push(packet);
+		}
+		catch (const std::overflow_error& e)
+		{
+			benchmark::DoNotOptimize(e);
+		}
+	}
+}
+
+static void BM_try_push_full(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+
+	const Packet packet {std::vector<uint8_t>(16u, 0x5Au)};
+
+	while (tx.tryPush(packet) == RingBufferStatus::Ok);
+
+	for (auto _ : state)
+	{
+		auto status = tx.tryPush(packet);
+		benchmark::DoNotOptimize(status);
+	}
+}
+
+/**
+ * Pulling into a Packet that is reused, the payload storage is allocated once.
+ */
+static void BM_try_push_pull_1(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, kSize, RingBufferMode::LockFree);
+
+	const Packet packet {
+		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+    };
+	Packet rxPacket;
+
+	for (auto _ : state)
+	{
+		static_cast<void>(tx.tryPush(packet));
+		static_cast<void>(rx.tryPull(rxPacket));
+		benchmark::DoNotOptimize(rxPacket.data.data());
+	}
+}
+
+/**
+ * Cost of keeping the ring statistics on the push and pull path.
+ */
+static void BM_try_push_pull_statistics(benchmark::State& state, bool statistics)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+
+	const RingBufferOptions options {.mode = RingBufferMode::LockFree, .statistics = statistics};
+	TxRingBuffer tx(buffer, kSize, options);
+	RxRingBuffer rx(buffer, kSize, options);
+
+	const Packet packet {std::vector<uint8_t>(15u, 0x5Au)};
+	Packet rxPacket;
+
+	for (auto _ : state)
+	{
+		static_cast<void>(tx.tryPush(packet));
+		static_cast<void>(rx.tryPull(rxPacket));
+		benchmark::DoNotOptimize(rxPacket.data.data());
+	}
+}
+
+/**
+ * Cost of 64-bit cursors against the 32-bit layout on the push and pull path.
+ */
+static void BM_try_push_pull_indices(benchmark::State& state, bool wideIndices)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+
+	const RingBufferOptions options {.mode = RingBufferMode::LockFree, .wideIndices = wideIndices};
+	TxRingBuffer tx(buffer, kSize, options);
+	RxRingBuffer rx(buffer, kSize, options);
+
+	const Packet packet {std::vector<uint8_t>(15u, 0x5Au)};
+	Packet rxPacket;
+
+	for (auto _ : state)
+	{
+		static_cast<void>(tx.tryPush(packet));
+		static_cast<void>(rx.tryPull(rxPacket));
+		benchmark::DoNotOptimize(rxPacket.data.data());
+	}
+}
+
+/**
+ * Large payload written through a Packet: the payload is built in a vector,
+ * copied into the Packet and copied again into the ring buffer.
+ */
+static void BM_push_large(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(256u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, kSize, RingBufferMode::LockFree);
+
+	const auto payloadSize {static_cast<std::size_t>(state.range(0))};
+
+	for (auto _ : state)
+	{
+		std::vector<uint8_t> payload(payloadSize);
+		std::fill(payload.begin(), payload.end(), 0x5Au);
+		tx.push(Packet {payload});
+
+		auto p1 = rx.pull();
+		benchmark::DoNotOptimize(p1);
+	}
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Copy throughput with and without per-packet checksums, the payload is
+ * checksummed while it is copied in and verified while it is copied out.
+ */
+static void BM_push_pull_checksum(benchmark::State& state, bool checksum)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(256u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	const RingBufferOptions options {.mode = RingBufferMode::LockFree, .checksum = checksum};
+	TxRingBuffer tx(buffer, kSize, options);
+	RxRingBuffer rx(buffer, kSize, options);
+
+	const Packet txPacket {std::vector<uint8_t>(static_cast<std::size_t>(state.range(0)), 0x5Au)};
+	Packet rxPacket;
+
+	for (auto _ : state)
+	{
+		tx.push(txPacket);
+
+		if (rx.tryPull(rxPacket) != RingBufferStatus::Ok)
+		{
+			state.SkipWithError("Pull failed");
+			break;
+		}
+
+		benchmark::DoNotOptimize(rxPacket.data.data());
+	}
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Large payload written in place through reserve/commit.
+ */
+static void BM_reserve_commit_large(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(256u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, kSize, RingBufferMode::LockFree);
+
+	const auto payloadSize {static_cast<std::size_t>(state.range(0))};
+
+	for (auto _ : state)
+	{
+		auto region = tx.reserve(payloadSize);
+		std::fill(region.first.begin(), region.first.end(), 0x5Au);
+		std::fill(region.second.begin(), region.second.end(), 0x5Au);
+		tx.commit();
+
+		auto p1 = rx.pull();
+		benchmark::DoNotOptimize(p1);
+	}
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Large payload written and read in place, no copies on either side.
+ */
+static void BM_reserve_peek_large(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(256u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, kSize, RingBufferMode::LockFree);
+
+	const auto payloadSize {static_cast<std::size_t>(state.range(0))};
+
+	for (auto _ : state)
+	{
+		auto region = tx.reserve(payloadSize);
+		std::fill(region.first.begin(), region.first.end(), 0x5Au);
+		std::fill(region.second.begin(), region.second.end(), 0x5Au);
+		tx.commit();
+
+		const auto view = rx.peek();
+		benchmark::DoNotOptimize(view.data.first.data());
+		rx.release();
+	}
+
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+#ifdef __linux__
+/**
+ * Packets sized so that they regularly straddle the end of a 64KB ring placed
+ * in a shared memory segment, read through peek. A mirrored segment hands out
+ * every packet in one piece, a plain one splits the straddling packets in two.
+ */
+static void BM_wrap_push_peek(benchmark::State& state, bool mirrored)
+{
+	constexpr std::size_t kCapacity {64u * 1024u};
+	constexpr std::size_t kPageSize {4096u};
+
+	auto sharedMemory = MakeUniqueSharedMemory();
+	sharedMemory->create("/smipc.wrap-benchmark", kCapacity + kPageSize, {.mirrored = mirrored, .mirrorOffset = sizeof(RingBuffer::RingBufferHeader)});
+
+	auto* memory = reinterpret_cast<uint8_t*>(sharedMemory->getView().data);
+	const RingBufferOptions options {.mode = RingBufferMode::LockFree, .mirrored = sharedMemory->isMirrored()};
+	TxRingBuffer tx(memory, *sharedMemory->getView().dataSize, options);
+	RxRingBuffer rx(memory, *sharedMemory->getView().dataSize, options);
+
+	const std::vector<uint8_t> payload(static_cast<std::size_t>(state.range(0)), 0x5Au);
+	uint64_t checksum {0u};
+
+	for (auto _ : state)
+	{
+		tx.push(Packet {payload});
+
+		const auto view = rx.peek();
+
+		for (const auto part : {view.data.first, view.data.second})
+		{
+			checksum = std::accumulate(part.begin(), part.end(), checksum);
+		}
+
+		rx.release();
+	}
+
+	benchmark::DoNotOptimize(checksum);
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+	sharedMemory->close();
+}
+#endif
+
+/**
+ * Large messages through a 1 MB pipe, fragmented by a writer thread and
+ * reassembled into a reused buffer while later fragments are still written.
+ */
+static void BM_message_fragmentation(benchmark::State& state)
+{
+	constexpr std::size_t kSharedMemorySize {1024u * 1024u};
+
+	const auto hostPipe = CreateSharedMemoryPipe("fragmentation-benchmark", kSharedMemorySize);
+	const auto clientPipe = OpenSharedMemoryPipe("fragmentation-benchmark");
+
+	const std::vector<uint8_t> message(static_cast<std::size_t>(state.range(0)), 0x5Au);
+	const auto messageCount {state.max_iterations};
+
+	std::thread writer([&hostPipe, &message, messageCount]()
+		{
+			for (benchmark::IterationCount i = 0; i < messageCount; ++i)
+			{
+				static_cast<void>(hostPipe->writeMessage(message));
+			}
+		});
+
+	PacketBuffer received;
+
+	for (auto _ : state)
+	{
+		static_cast<void>(clientPipe->readMessage(received));
+		benchmark::DoNotOptimize(received.data());
+	}
+
+	writer.join();
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_push_peek_1(benchmark::State& state)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(1024u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
+
+	TxRingBuffer tx(buffer, kSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, kSize, RingBufferMode::LockFree);
+
+	Packet packet {
+		std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+    };
+
+	for (auto _ : state)
+	{
+		tx.push(packet);
+		const auto view = rx.peek();
+		benchmark::DoNotOptimize(view.data.first.data());
+		rx.release();
+	}
+}
+
+/**
+ * A burst of small packets pushed one at a time, then drained.
+ */
+static void BM_push_burst(benchmark::State& state, RingBufferMode mode)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
+
+	const std::vector<Packet> packets(static_cast<std::size_t>(state.range(0)), Packet {std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}});
+
+	for (auto _ : state)
+	{
+		for (const auto& packet : packets)
+		{
+			tx.push(packet);
+		}
+
+		state.PauseTiming();
+		while (! rx.isEmpty())
+		{
+			rx.release();
+		}
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * The same burst pushed with a single pushBatch call.
+ */
+static void BM_push_batch(benchmark::State& state, RingBufferMode mode)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
+
+	const std::vector<Packet> packets(static_cast<std::size_t>(state.range(0)), Packet {std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}});
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(tx.pushBatch(packets));
+
+		state.PauseTiming();
+		while (! rx.isEmpty())
+		{
+			rx.release();
+		}
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * A burst consumed the way the server used to: isEmpty then pull per packet.
+ */
+static void BM_pull_burst(benchmark::State& state, RingBufferMode mode)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
+
+	const std::vector<Packet> packets(static_cast<std::size_t>(state.range(0)), Packet {std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}});
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		benchmark::DoNotOptimize(tx.pushBatch(packets));
+		state.ResumeTiming();
+
+		while (! rx.isEmpty())
+		{
+			auto p1 = rx.pull();
+			benchmark::DoNotOptimize(p1);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * The same burst consumed in place with a single drain call.
+ */
+static void BM_drain_burst(benchmark::State& state, RingBufferMode mode)
+{
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(64u * 1024u);
+	alignas(kCacheLineSize) static uint8_t buffer[kSize] {};
+	std::fill_n(buffer, kSize, 0u);
+
+	TxRingBuffer tx(buffer, kSize, mode);
+	RxRingBuffer rx(buffer, kSize, mode);
+
+	const std::vector<Packet> packets(static_cast<std::size_t>(state.range(0)), Packet {std::vector<uint8_t> {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}});
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		benchmark::DoNotOptimize(tx.pushBatch(packets));
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(rx.drain([](const PacketView& view) { benchmark::DoNotOptimize(view.data.first.data()); }));
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Ring variants for BM_stream_throughput. Each one sets a producer and a
+ * consumer up on the same memory, new variants only need these members.
+ * The lock policy only matters to Locked rings.
+ */
+template <RingBufferMode kMode, LockPolicy kLockPolicy = LockPolicy::Dekker>
+struct SpscStream
+{
+	static constexpr auto GetMemoryBlockSize(std::size_t capacity) noexcept -> std::size_t
+	{
+		return RingBuffer::GetMemoryBlockSize(capacity);
+	}
+
+	SpscStream(uint8_t* memory, std::size_t size)
+		: tx {memory, size, RingBufferOptions {.mode = kMode, .lockPolicy = kLockPolicy}}
+		, rx {memory, size, RingBufferOptions {.mode = kMode, .lockPolicy = kLockPolicy}}
+	{}
+
+	auto tryPush(const Packet& packet) -> RingBufferStatus
+	{
+		return tx.tryPush(packet);
+	}
+
+	auto tryPull(Packet& packet) -> RingBufferStatus
+	{
+		return rx.tryPull(packet);
+	}
+
+	TxRingBuffer tx;
+	RxRingBuffer rx;
+};
+
+struct MpscStream
+{
+	static constexpr auto GetMemoryBlockSize(std::size_t capacity) noexcept -> std::size_t
+	{
+		return MpscRingBuffer::GetMemoryBlockSize(capacity);
+	}
+
+	MpscStream(uint8_t* memory, std::size_t size)
+		: tx {memory, size}
+		, rx {memory, size}
+	{}
+
+	auto tryPush(const Packet& packet) noexcept -> RingBufferStatus
+	{
+		return tx.tryPush(packet);
+	}
+
+	auto tryPull(Packet& packet) -> RingBufferStatus
+	{
+		return rx.tryPull(packet);
+	}
+
+	MpscTxRingBuffer tx;
+	MpscRxRingBuffer rx;
+};
+
+/**
+ * Sustained throughput of one producer thread streaming into one consumer
+ * thread, over ring capacities from 4 KiB to 256 MiB and a range of message
+ * sizes. The ring is allocated and faulted in before timing starts.
+ */
+template <class Stream>
+static void BM_stream_throughput(benchmark::State& state)
+{
+	const auto capacity {static_cast<std::size_t>(state.range(0))};
+	const auto messageSize {static_cast<std::size_t>(state.range(1))};
+
+	const std::size_t size {Stream::GetMemoryBlockSize(capacity)};
+	const std::unique_ptr<uint8_t, decltype(&std::free)> memory {static_cast<uint8_t*>(std::aligned_alloc(kCacheLineSize, size)), &std::free};
+
+	if (! memory)
+	{
+		state.SkipWithError("Failed to allocate the ring");
+		return;
+	}
+
+	std::fill_n(memory.get(), size, 0u);
+	Stream stream {memory.get(), size};
+
+	const Packet packet {std::vector<uint8_t>(messageSize, 0x5Au)};
+	const auto packetCount {state.max_iterations};
+
+	// Only a full ring is worth retrying, anything else would never go through
+	std::atomic<RingBufferStatus> producerStatus {RingBufferStatus::Ok};
+	std::atomic_bool consumerStopped {false};
+
+	std::thread producer([&stream, &packet, &producerStatus, &consumerStopped, packetCount]()
+		{
+			for (benchmark::IterationCount i = 0; i < packetCount; ++i)
+			{
+				RingBufferStatus status {};
+
+				while ((status = stream.tryPush(packet)) == RingBufferStatus::Full)
+				{
+					if (consumerStopped.load(std::memory_order_relaxed))
+					{
+						return;
+					}
+
+					std::this_thread::yield();
+				}
+
+				if (status != RingBufferStatus::Ok)
+				{
+					producerStatus.store(status, std::memory_order_release);
+					return;
+				}
+			}
+		});
+
+	Packet received;
+
+	for (auto _ : state)
+	{
+		RingBufferStatus status {};
+
+		while ((status = stream.tryPull(received)) == RingBufferStatus::Empty && producerStatus.load(std::memory_order_acquire) == RingBufferStatus::Ok)
+		{
+			std::this_thread::yield();
+		}
+
+		if (status != RingBufferStatus::Ok)
+		{
+			state.SkipWithError(status == RingBufferStatus::Empty ? "The producer failed to push" : "The consumer failed to pull");
+			break;
+		}
+	}
+
+	consumerStopped.store(true, std::memory_order_relaxed);
+	producer.join();
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+static void StreamArguments(benchmark::internal::Benchmark* benchmark)
+{
+	benchmark->ArgNames({"ring", "message"});
+
+	for (const int64_t capacity : {4 << 10, 64 << 10, 1 << 20, 16 << 20, 256 << 20})
+	{
+		for (const int64_t messageSize : {64, 1 << 10, 16 << 10})
+		{
+			// Only rings that hold a few messages at once, anything less measures the hand off
+			if (4 * messageSize <= capacity)
+			{
+				benchmark->Args({capacity, messageSize});
+			}
+		}
+	}
+
+	benchmark->UseRealTime();
+}
+
+BENCHMARK_CAPTURE(BM_push_pop_1, locked, RingBufferMode::Locked);
+BENCHMARK_CAPTURE(BM_push_pop_1, lock_free, RingBufferMode::LockFree);
+BENCHMARK_CAPTURE(BM_push_pop_4, locked, RingBufferMode::Locked);
+BENCHMARK_CAPTURE(BM_push_pop_4, lock_free, RingBufferMode::LockFree);
+BENCHMARK_CAPTURE(BM_two_thread_push_pop, locked, RingBufferMode::Locked)->UseRealTime();
+BENCHMARK_CAPTURE(BM_two_thread_push_pop, lock_free, RingBufferMode::LockFree)->UseRealTime();
+BENCHMARK_CAPTURE(BM_two_thread_contended, busy_spin, WaitStrategy::BusySpin)->UseRealTime();
+BENCHMARK_CAPTURE(BM_two_thread_contended, backoff, WaitStrategy::Backoff)->UseRealTime();
+BENCHMARK_CAPTURE(BM_two_thread_contended, spin_yield, WaitStrategy::SpinYield)->UseRealTime();
+BENCHMARK_CAPTURE(BM_two_thread_contended, adaptive, WaitStrategy::Adaptive)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lock_policy_threads, dekker, LockPolicy::Dekker)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lock_policy_threads, ttas, LockPolicy::TestAndTestAndSet)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lock_policy_threads, ticket, LockPolicy::Ticket)->UseRealTime();
+#ifdef __linux__
+BENCHMARK_CAPTURE(BM_lock_policy_threads, robust_mutex, LockPolicy::RobustMutex)->UseRealTime();
+#endif
+BENCHMARK(BM_mpsc_producers)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(BM_fan_out_unicast)->Arg(1)->Arg(16)->Arg(200);
+BENCHMARK(BM_fan_out_broadcast)->Arg(1)->Arg(16)->Arg(200);
+BENCHMARK(BM_push_pull_allocations)->Arg(15)->Arg(64)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_push_full);
+BENCHMARK(BM_try_push_full);
+BENCHMARK(BM_try_push_pull_1);
+BENCHMARK_CAPTURE(BM_try_push_pull_statistics, off, false);
+BENCHMARK_CAPTURE(BM_try_push_pull_indices, narrow, false);
+BENCHMARK_CAPTURE(BM_try_push_pull_indices, wide, true);
+BENCHMARK_CAPTURE(BM_try_push_pull_statistics, on, true);
+BENCHMARK(BM_push_large)->Arg(4096)->Arg(16384)->Arg(65536);
+BENCHMARK_CAPTURE(BM_push_pull_checksum, off, false)->Arg(64)->Arg(4096)->Arg(65536);
+BENCHMARK_CAPTURE(BM_push_pull_checksum, on, true)->Arg(64)->Arg(4096)->Arg(65536);
+BENCHMARK(BM_reserve_commit_large)->Arg(4096)->Arg(16384)->Arg(65536);
+BENCHMARK(BM_reserve_peek_large)->Arg(4096)->Arg(16384)->Arg(65536);
+BENCHMARK(BM_push_peek_1);
+BENCHMARK(BM_message_fragmentation)->Arg(1024 * 1024)->Arg(16 * 1024 * 1024)->Arg(100 * 1024 * 1024)->UseRealTime();
+#ifdef __linux__
+BENCHMARK_CAPTURE(BM_wrap_push_peek, plain, false)->Arg(1000)->Arg(10000)->Arg(30000);
+BENCHMARK_CAPTURE(BM_wrap_push_peek, mirrored, true)->Arg(1000)->Arg(10000)->Arg(30000);
+#endif
+BENCHMARK_CAPTURE(BM_push_burst, locked, RingBufferMode::Locked)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK_CAPTURE(BM_push_batch, locked, RingBufferMode::Locked)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK_CAPTURE(BM_push_burst, lock_free, RingBufferMode::LockFree)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK_CAPTURE(BM_push_batch, lock_free, RingBufferMode::LockFree)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK_CAPTURE(BM_pull_burst, locked, RingBufferMode::Locked)->RangeMultiplier(8)->Range(8, 512);
+BENCHMARK_CAPTURE(BM_drain_burst, locked, RingBufferMode::Locked)->RangeMultiplier(8)->Range(8, 512);
+BENCHMARK_CAPTURE(BM_pull_burst, lock_free, RingBufferMode::LockFree)->RangeMultiplier(8)->Range(8, 512);
+BENCHMARK_CAPTURE(BM_drain_burst, lock_free, RingBufferMode::LockFree)->RangeMultiplier(8)->Range(8, 512);
+
+BENCHMARK_TEMPLATE(BM_stream_throughput, SpscStream<RingBufferMode::Locked, LockPolicy::Dekker>)->Apply(StreamArguments);
+BENCHMARK_TEMPLATE(BM_stream_throughput, SpscStream<RingBufferMode::Locked, LockPolicy::TestAndTestAndSet>)->Apply(StreamArguments);
+BENCHMARK_TEMPLATE(BM_stream_throughput, SpscStream<RingBufferMode::Locked, LockPolicy::Ticket>)->Apply(StreamArguments);
+#ifdef __linux__
+BENCHMARK_TEMPLATE(BM_stream_throughput, SpscStream<RingBufferMode::Locked, LockPolicy::RobustMutex>)->Apply(StreamArguments);
+#endif
+BENCHMARK_TEMPLATE(BM_stream_throughput, SpscStream<RingBufferMode::LockFree>)->Apply(StreamArguments);
+BENCHMARK_TEMPLATE(BM_stream_throughput, MpscStream)->Apply(StreamArguments);
 
 BENCHMARK_MAIN();
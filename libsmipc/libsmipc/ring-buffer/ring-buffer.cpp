@@ -22,17 +22,52 @@
  */
 
 #include <libsmipc/ring-buffer/ring-buffer.hpp>
+#include <libsmipc/ring-buffer/crc32c.hpp>
+#include <libsmipc/ring-buffer/futex.hpp>
+#include <libsmipc/ring-buffer/robust-mutex.hpp>
 
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
 
-RingBuffer::RingBuffer(uint8_t* memory, std::size_t size)
+[[nodiscard]]
+auto ClaimRingBufferHeader(std::atomic<uint32_t>& version) -> uint32_t
+{
+	const auto deadline {std::chrono::steady_clock::now() + kRingBufferSetupTimeout};
+	uint32_t current {0u};
+
+	while (! version.compare_exchange_strong(current, kRingBufferInitialising, std::memory_order_acquire, std::memory_order_acquire))
+	{
+		if (current != kRingBufferInitialising)
+		{
+			return current;
+		}
+
+		if (std::chrono::steady_clock::now() >= deadline)
+		{
+			throw std::runtime_error("Timed out waiting for the ring buffer header to be laid out");
+		}
+
+		std::this_thread::yield();
+		current = 0u;
+	}
+
+	return 0u;
+}
+
+RingBuffer::RingBuffer(uint8_t* memory, std::size_t size, RingBufferMode mode)
+	: RingBuffer {memory, size, RingBufferOptions {.mode = mode}}
+{}
+
+RingBuffer::RingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options)
 	: m_memory {memory, size}
 	, header {reinterpret_cast<RingBufferHeader*>(m_memory.data())}
 	, data {m_memory.begin() + sizeof(RingBufferHeader), size - sizeof(RingBufferHeader)}
+	, options {options}
 {
-	if (reinterpret_cast<uintptr_t>(memory) % kAlignment != 0u)
+	if (reinterpret_cast<uintptr_t>(memory) % kCacheLineSize != 0u)
 	{
-		throw std::invalid_argument("Memory must be 4 byte aligned");
+		throw std::invalid_argument("Memory must be 64 byte aligned");
 	}
 
 	if (size % kAlignment != 0u)
@@ -45,16 +80,294 @@ RingBuffer::RingBuffer(uint8_t* memory, std::size_t size)
 		throw std::invalid_argument("Buffer size is too small");
 	}
 
-	if (size > 2048u * 1024u * 1024u)
+#ifndef __linux__
+	if (options.lockPolicy == LockPolicy::RobustMutex)
+	{
+		throw std::invalid_argument("Robust mutexes are not supported on this platform");
+	}
+#endif
+
+	// Whichever side claims the header lays it out, the other waits for it and validates it
+	const uint32_t version {ClaimRingBufferHeader(header->version)};
+
+	if (version == 0u)
+	{
+		// Rings too large for 32-bit cursors get the wide layout whether asked or not
+		this->options.wideIndices = options.wideIndices || getCapacity() > kMaxNarrowCapacity;
+		header->capacity = getCapacity();
+		header->lockPolicy = options.lockPolicy;
+
+#ifdef __linux__
+		if (options.lockPolicy == LockPolicy::RobustMutex)
+		{
+			try
+			{
+				RobustMutex::Initialise(header->mutex);
+			}
+			catch (...)
+			{
+				header->version.store(0u, std::memory_order_release);
+				throw;
+			}
+		}
+#endif
+
+		header->version.store(this->options.wideIndices ? kRingBufferVersion | kRingBufferWideIndexTag : kRingBufferVersion, std::memory_order_release);
+		return;
+	}
+
+	if ((version & ~kRingBufferWideIndexTag) != kRingBufferVersion)
+	{
+		throw std::invalid_argument("Unsupported ring buffer header version");
+	}
+
+	// The layout is the creator's choice
+	this->options.wideIndices = (version & kRingBufferWideIndexTag) != 0u;
+
+	if (header->capacity != getCapacity())
+	{
+		throw std::invalid_argument("Buffer size does not match the existing ring buffer");
+	}
+	else if (header->lockPolicy != options.lockPolicy)
+	{
+		throw std::invalid_argument("Lock policy does not match the existing ring buffer");
+	}
+}
+
+[[nodiscard]]
+auto RingBuffer::getMemoryBlockSize() const noexcept -> std::size_t
+{
+	return m_memory.size();
+}
+
+[[nodiscard]]
+auto RingBuffer::getMode() const noexcept -> RingBufferMode
+{
+	return options.mode;
+}
+
+[[nodiscard]]
+auto RingBuffer::isMirrored() const noexcept -> bool
+{
+	return options.mirrored;
+}
+
+[[nodiscard]]
+static auto LoadStatistics(const RingBuffer::RingBufferHeader& ringHeader) noexcept -> RingBufferStatistics
+{
+	return {
+		.capacity = ringHeader.capacity,
+		.pushedPackets = ringHeader.pushedPackets.load(std::memory_order_relaxed),
+		.pushedBytes = ringHeader.pushedBytes.load(std::memory_order_relaxed),
+		.fullCount = ringHeader.fullCount.load(std::memory_order_relaxed),
+		.highWaterMark = ringHeader.highWaterMark.load(std::memory_order_relaxed),
+		.txLockSpins = ringHeader.txLockSpins.load(std::memory_order_relaxed),
+		.pulledPackets = ringHeader.pulledPackets.load(std::memory_order_relaxed),
+		.pulledBytes = ringHeader.pulledBytes.load(std::memory_order_relaxed),
+		.emptyCount = ringHeader.emptyCount.load(std::memory_order_relaxed),
+		.rxLockSpins = ringHeader.rxLockSpins.load(std::memory_order_relaxed),
+	};
+}
+
+[[nodiscard]]
+auto RingBuffer::getStatistics() const noexcept -> RingBufferStatistics
+{
+	return LoadStatistics(*header);
+}
+
+/**
+ * Find the header of a ring buffer that someone else set up.
+ */
+[[nodiscard]]
+static auto GetExistingHeader(std::span<const uint8_t> memory) -> const RingBuffer::RingBufferHeader&
+{
+	if (memory.size() <= sizeof(RingBuffer::RingBufferHeader) || reinterpret_cast<uintptr_t>(memory.data()) % kCacheLineSize != 0u)
+	{
+		throw std::invalid_argument("Memory does not hold a ring buffer");
+	}
+
+	const auto& ringHeader {*reinterpret_cast<const RingBuffer::RingBufferHeader*>(memory.data())};
+
+	if ((ringHeader.version.load(std::memory_order_acquire) & ~kRingBufferWideIndexTag) != kRingBufferVersion)
 	{
-		throw std::invalid_argument("Buffer size is too large, must be less than 2GB");
+		throw std::invalid_argument("Unsupported ring buffer header version");
 	}
 
-	header->freeSpace = static_cast<uint32_t>(data.size());
+	return ringHeader;
+}
+
+[[nodiscard]]
+static auto LoadLatency([[maybe_unused]] const RingBuffer::RingBufferHeader& ringHeader) noexcept -> LatencySnapshot
+{
+#ifdef SMIPC_LATENCY_TRACING
+	return ringHeader.latency.snapshot();
+#else
+	return {};
+#endif
+}
+
+[[nodiscard]]
+auto RingBuffer::ReadStatistics(std::span<const uint8_t> memory) -> RingBufferStatistics
+{
+	return LoadStatistics(GetExistingHeader(memory));
+}
+
+[[nodiscard]]
+auto RingBuffer::getLatency() const noexcept -> LatencySnapshot
+{
+	return LoadLatency(*header);
 }
 
 [[nodiscard]]
-auto RingBuffer::getMemoryBlockSize() const noexcept -> uint32_t
+auto RingBuffer::ReadLatency(std::span<const uint8_t> memory) -> LatencySnapshot
 {
-	return static_cast<uint32_t>(m_memory.size());
+	return LoadLatency(GetExistingHeader(memory));
+}
+
+auto RingBuffer::getSpan(uint64_t cursor, uint32_t count) noexcept -> RingBufferSpan<uint8_t>
+{
+	const uint64_t start {getOffset(cursor)};
+
+	// The mirror mapping continues past the end of the data region, so nothing wraps
+	if (options.mirrored)
+	{
+		return {{data.data() + start, count}, {}};
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(count, data.size() - start)};
+
+	return {data.subspan(start, part1Size), data.first(count - part1Size)};
+}
+
+auto RingBuffer::getSpan(uint64_t cursor, uint32_t count) const noexcept -> RingBufferSpan<const uint8_t>
+{
+	const uint64_t start {getOffset(cursor)};
+
+	if (options.mirrored)
+	{
+		return {{data.data() + start, count}, {}};
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(count, data.size() - start)};
+
+	return {data.subspan(start, part1Size), data.first(count - part1Size)};
+}
+
+void RingBuffer::copyIn(uint64_t cursor, std::span<const uint8_t> source) noexcept
+{
+	const uint64_t start {getOffset(cursor)};
+
+	if (options.mirrored)
+	{
+		std::copy_n(std::cbegin(source), source.size(), data.data() + start);
+		return;
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(source.size(), data.size() - start)};
+
+	std::copy_n(std::cbegin(source), part1Size, std::begin(data) + start);
+	std::copy_n(std::cbegin(source) + part1Size, source.size() - part1Size, std::begin(data));
+}
+
+void RingBuffer::copyOut(uint64_t cursor, std::span<uint8_t> destination) const noexcept
+{
+	const uint64_t start {getOffset(cursor)};
+
+	if (options.mirrored)
+	{
+		std::copy_n(data.data() + start, destination.size(), std::begin(destination));
+		return;
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(destination.size(), data.size() - start)};
+
+	std::copy_n(std::cbegin(data) + start, part1Size, std::begin(destination));
+	std::copy_n(std::cbegin(data), destination.size() - part1Size, std::begin(destination) + part1Size);
+}
+
+[[nodiscard]]
+auto RingBuffer::copyInChecksum(uint64_t cursor, std::span<const uint8_t> source) noexcept -> uint32_t
+{
+	const auto destination {getSpan(cursor, static_cast<uint32_t>(source.size()))};
+	const uint32_t crc {CopyCrc32c(source.first(destination.first.size()), destination.first.data())};
+
+	return CopyCrc32c(source.subspan(destination.first.size()), destination.second.data(), crc);
+}
+
+[[nodiscard]]
+auto RingBuffer::copyOutChecksum(uint64_t cursor, std::span<uint8_t> destination) const noexcept -> uint32_t
+{
+	const auto source {getSpan(cursor, static_cast<uint32_t>(destination.size()))};
+	const uint32_t crc {CopyCrc32c(source.first, destination.data())};
+
+	return CopyCrc32c(source.second, destination.data() + source.first.size(), crc);
+}
+
+[[nodiscard]]
+auto RingBuffer::getChecksum(uint64_t cursor, uint32_t count) const noexcept -> uint32_t
+{
+	const auto source {getSpan(cursor, count)};
+	return Crc32c(source.second, Crc32c(source.first));
+}
+
+void RingBuffer::clear(uint64_t cursor, uint32_t count) noexcept
+{
+	const uint64_t start {getOffset(cursor)};
+
+	if (options.mirrored)
+	{
+		std::fill_n(data.data() + start, count, 0u);
+		return;
+	}
+
+	const std::size_t part1Size {std::min<std::size_t>(count, data.size() - start)};
+
+	std::fill_n(std::begin(data) + start, part1Size, 0u);
+	std::fill_n(std::begin(data), count - part1Size, 0u);
+}
+
+[[nodiscard]]
+auto RingBuffer::GetDeadline(std::chrono::nanoseconds timeout) noexcept -> Deadline
+{
+	const auto now {std::chrono::steady_clock::now()};
+	return timeout >= Deadline::max() - now ? Deadline::max() : now + timeout;
+}
+
+[[nodiscard]]
+auto RingBuffer::park(std::atomic<uint32_t>& count, uint32_t expected, std::atomic_bool& parked, Deadline deadline, Waiter& waiter) const noexcept -> bool
+{
+	const auto now {std::chrono::steady_clock::now()};
+
+	if (now >= deadline)
+	{
+		return false;
+	}
+
+	if (! waiter.isExhausted())
+	{
+		waiter.wait();
+		return true;
+	}
+
+	// The flag has to be visible before the futex re-reads the cursor, pairs with storeAndWake
+	parked.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	FutexWait(count, expected, deadline == Deadline::max() ? std::chrono::nanoseconds::max() : deadline - now);
+
+	parked.store(false, std::memory_order_relaxed);
+	return true;
+}
+
+void RingBuffer::storeAndWake(std::atomic<uint32_t>& count, uint32_t value, const std::atomic_bool& parked) const noexcept
+{
+	count.store(value, std::memory_order_release);
+
+	// Either the sleeper sees the new count or we see its flag
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (parked.load(std::memory_order_relaxed))
+	{
+		FutexWake(count);
+	}
 }
@@ -24,11 +24,19 @@
 #ifndef RING_BUFFER_H_
 #define RING_BUFFER_H_
 
+#include <libsmipc/ring-buffer/latency-histogram.hpp>
+#include <libsmipc/ring-buffer/wait-strategy.hpp>
+
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <span>
 #include <stdexcept>
 
+#ifdef __linux__
+#	include <pthread.h>
+#endif
+
 constexpr bool IsDebugBuild()
 {
 #ifdef NDEBUG
@@ -39,40 +47,422 @@ constexpr bool IsDebugBuild()
 }
 
 static constexpr std::size_t kAlignment {4u};
+static constexpr std::size_t kCacheLineSize {64u};
+// Latency tracing builds lay packets out differently, the top bit keeps them from attaching to rings of other builds
+static constexpr uint32_t kRingBufferVersion {IsLatencyTracingBuild() ? 0x80000006u : 6u};
+// Set in the version of a ring buffer whose cursors are 64-bit
+static constexpr uint32_t kRingBufferWideIndexTag {0x40000000u};
+// Cursors run over [0, 2 * capacity), so this is the largest capacity 32-bit cursors can address
+static constexpr uint64_t kMaxNarrowCapacity {0x80000000u};
+// Held in the version of a ring buffer header while one side lays it out
+static constexpr uint32_t kRingBufferInitialising {0xFFFFFFFFu};
+// How long a side waits for a peer to finish laying out a header before giving up on it
+static constexpr std::chrono::seconds kRingBufferSetupTimeout {1};
 
 static constexpr uint32_t AlignedSize(uint32_t size)
 {
 	return size + ((kAlignment - (size % kAlignment)) % kAlignment);
 }
 
+/**
+ * Decide which side lays out a ring buffer header.
+ *
+ * The side that moves the version from 0 to kRingBufferInitialising gets 0
+ * back and has to lay the header out, then publish the final version (or put
+ * back 0 if it fails). Every other side waits for that and gets the final
+ * version to validate.
+ *
+ * @throws std::runtime_error if the header is not laid out within
+ * kRingBufferSetupTimeout.
+ */
+[[nodiscard]]
+auto ClaimRingBufferHeader(std::atomic<uint32_t>& version) -> uint32_t;
+
+/**
+ * A region of the ring buffer that may wrap around the end of the data block.
+ *
+ * `first` starts at the requested position, `second` continues from the start
+ * of the data block and is empty unless the region wrapped.
+ */
+template <class T>
+struct RingBufferSpan
+{
+	std::span<T> first {};
+	std::span<T> second {};
+
+	[[nodiscard]]
+	constexpr auto size() const noexcept -> std::size_t
+	{
+		return first.size() + second.size();
+	}
+
+	[[nodiscard]]
+	constexpr auto isContiguous() const noexcept -> bool
+	{
+		return second.empty();
+	}
+
+	constexpr operator RingBufferSpan<const T>() const noexcept
+	{
+		return {first, second};
+	}
+};
+
+/**
+ * How a ring buffer synchronises its producer and consumer.
+ *
+ * The producer only ever writes the `next` cursor and the consumer only ever
+ * writes the `front` cursor, so a single producer and a single consumer never
+ * need a lock. Locked mode additionally takes the Dekker lock shared with the
+ * peer around every operation.
+ */
+enum class RingBufferMode : uint32_t
+{
+	Locked,
+	LockFree,
+};
+
+/**
+ * Which lock a Locked ring buffer takes around every operation.
+ *
+ * Dekker needs no atomic read-modify-write and suits two sides that take
+ * turns. TestAndTestAndSet is the cheapest when the lock is rarely contended.
+ * Ticket hands the lock out in order, so a busy side cannot starve the other.
+ * RobustMutex sleeps in the kernel when contended and is recovered if a peer
+ * dies holding it, it is only available on Linux.
+ *
+ * The ring buffer records the policy it was created with and refuses to
+ * attach with another one.
+ */
+enum class LockPolicy : uint32_t
+{
+	Dekker,
+	TestAndTestAndSet,
+	Ticket,
+	RobustMutex,
+};
+
+/**
+ * Outcome of the non-throwing ring buffer operations.
+ *
+ * Full and Empty are transient, retrying later can succeed. TooLarge means the
+ * packet would not fit even in an empty buffer. Overrun is only reported by
+ * broadcast readers that fell so far behind that packets were overwritten.
+ * ChecksumMismatch means a packet was pulled but its payload does not match
+ * the checksum the producer wrote.
+ */
+enum class RingBufferStatus : uint32_t
+{
+	Ok,
+	Full,
+	Empty,
+	TooLarge,
+	Overrun,
+	ChecksumMismatch,
+};
+
+/**
+ * Construction options for a ring buffer.
+ *
+ * A mirrored ring buffer sits on memory where the data region is mapped twice,
+ * back to back, so the bytes past the end of the data region are the bytes at
+ * its start. Packets that wrap can then be read and written in one piece.
+ *
+ * The wait strategy is local to each side, so a latency critical consumer can
+ * busy-spin while its producer backs off.
+ *
+ * With checksum set the producer stores a CRC-32C of every payload in the
+ * packet header, computed while copying the payload in, and the consumer
+ * verifies it while copying the payload out. Both sides must agree on it.
+ *
+ * With statistics set this side keeps its counters in the ring buffer header
+ * up to date, see RingBufferStatistics. Each side decides for itself.
+ *
+ * With wideIndices set the ring buffer is laid out with 64-bit cursors, which
+ * rings larger than kMaxNarrowCapacity always are. Only the side that creates
+ * the ring buffer picks the layout, the other side follows its header.
+ */
+struct RingBufferOptions
+{
+	RingBufferMode mode {RingBufferMode::Locked};
+	bool mirrored {false};
+	WaitStrategy waitStrategy {WaitStrategy::Adaptive};
+	bool checksum {false};
+	bool statistics {false};
+	LockPolicy lockPolicy {LockPolicy::Dekker};
+	bool wideIndices {false};
+};
+
+/**
+ * A snapshot of the counters kept in a ring buffer header.
+ *
+ * The producer counters only move while the producer has statistics enabled,
+ * the consumer counters likewise. Every counter is written by its owner alone,
+ * so keeping them costs a plain store on a cache line that side already owns,
+ * and a snapshot taken by anyone else is close to current rather than exact.
+ *
+ * fullCount counts pushes turned away or made to wait for lack of space,
+ * emptyCount counts pulls that found nothing to read. The high-water mark is
+ * the most bytes, packet headers included, ever in use at once. Lock spins
+ * count the waits for the peer in the Dekker lock, in Locked mode.
+ */
+struct RingBufferStatistics
+{
+	uint64_t capacity {};
+
+	uint64_t pushedPackets {};
+	uint64_t pushedBytes {};
+	uint64_t fullCount {};
+	uint64_t highWaterMark {};
+	uint64_t txLockSpins {};
+
+	uint64_t pulledPackets {};
+	uint64_t pulledBytes {};
+	uint64_t emptyCount {};
+	uint64_t rxLockSpins {};
+};
+
 class RingBuffer
 {
 public:
+	/**
+	 * A cursor in the ring buffer header, stored in 32 or 64 bits depending
+	 * on the layout. The slot is 64 bits either way, so both layouts share
+	 * the header.
+	 */
+	union RingCursor
+	{
+		std::atomic<uint32_t> narrow;
+		std::atomic<uint64_t> wide {};
+	};
+
+	/**
+	 * Cursors run over [0, 2 * capacity) so that a full buffer can be told
+	 * apart from an empty one without a shared free space counter.
+	 *
+	 * The producer and consumer owned fields live on separate cache lines so
+	 * that neither side invalidates the line the other one is writing. The
+	 * header is a whole number of cache lines, which keeps the data region
+	 * cache line aligned as well.
+	 *
+	 * The parked flags are set by a side sleeping in a blocking push or pull,
+	 * the other side only makes the wake up call when it sees one set. A
+	 * sleeper waits on the peer's packet count rather than its cursor, the
+	 * count changes with every publish where the low word of a 64-bit cursor
+	 * might not.
+	 */
 	struct RingBufferHeader
 	{
-		std::atomic_bool rxWaiting {false};
-		std::atomic_bool txWaiting {false};
+		// Written once on initialisation, only the Dekker lock writes turn
+		alignas(kCacheLineSize) std::atomic<uint32_t> version {};
+		LockPolicy lockPolicy {};
+		uint64_t capacity {};
 		std::atomic_bool turn {false};
-		uint8_t padding_ {};
 
-		uint32_t front {};
-		uint32_t next {};
-		uint32_t freeSpace {};
-		uint32_t messageCount {};
+		// Written by whichever side holds the lock, the lock policy picks the fields used
+		alignas(kCacheLineSize) std::atomic_bool spinLock {false};
+		std::atomic<uint32_t> ticketNext {};
+		std::atomic<uint32_t> ticketServing {};
+#ifdef __linux__
+		pthread_mutex_t mutex {};
+#endif
+
+		// Only written by the producer
+		alignas(kCacheLineSize) RingCursor next {};
+		std::atomic<uint32_t> pushCount {};
+		std::atomic_bool txWaiting {false};
+		std::atomic_bool txParked {false};
+		std::atomic<uint64_t> pushedPackets {};
+		std::atomic<uint64_t> pushedBytes {};
+		std::atomic<uint64_t> fullCount {};
+		std::atomic<uint64_t> highWaterMark {};
+		std::atomic<uint64_t> txLockSpins {};
+
+		// Only written by the consumer
+		alignas(kCacheLineSize) RingCursor front {};
+		std::atomic<uint32_t> pullCount {};
+		std::atomic_bool rxWaiting {false};
+		std::atomic_bool rxParked {false};
+		std::atomic<uint32_t> checksumMismatchCount {};
+		std::atomic<uint64_t> pulledPackets {};
+		std::atomic<uint64_t> pulledBytes {};
+		std::atomic<uint64_t> emptyCount {};
+		std::atomic<uint64_t> rxLockSpins {};
+
+#ifdef SMIPC_LATENCY_TRACING
+		// Only written by the consumer
+		alignas(kCacheLineSize) LatencyHistogram latency {};
+#endif
 	};
 
-	RingBuffer(uint8_t* memory, std::size_t size);
+	static_assert(sizeof(RingBufferHeader) % kCacheLineSize == 0u);
+
+	RingBuffer(uint8_t* memory, std::size_t size, RingBufferMode mode = RingBufferMode::Locked);
+	RingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options);
 	~RingBuffer() = default;
 
 	[[nodiscard]]
-	auto getMemoryBlockSize() const noexcept -> uint32_t;
+	auto getMemoryBlockSize() const noexcept -> std::size_t;
+
+	[[nodiscard]]
+	auto getMode() const noexcept -> RingBufferMode;
+
+	[[nodiscard]]
+	auto isMirrored() const noexcept -> bool;
+
+	[[nodiscard]]
+	auto getStatistics() const noexcept -> RingBufferStatistics;
+
+	/**
+	 * Read the statistics of a ring buffer without attaching to it, for
+	 * monitoring from outside the producer and consumer.
+	 *
+	 * @param memory The memory block holding the ring buffer.
+	 * @throws std::invalid_argument if the memory does not hold a ring buffer
+	 * of this version.
+	 */
+	[[nodiscard]]
+	static auto ReadStatistics(std::span<const uint8_t> memory) -> RingBufferStatistics;
+
+	/**
+	 * Get the latency from push to pull of the packets pulled so far, empty
+	 * unless latency tracing is compiled in.
+	 */
+	[[nodiscard]]
+	auto getLatency() const noexcept -> LatencySnapshot;
+
+	/**
+	 * Read the latency histogram of a ring buffer without attaching to it.
+	 *
+	 * @see ReadStatistics
+	 */
+	[[nodiscard]]
+	static auto ReadLatency(std::span<const uint8_t> memory) -> LatencySnapshot;
+
+	[[nodiscard]]
+	auto getCapacity() const noexcept -> uint64_t
+	{
+		return data.size();
+	}
+
+	[[nodiscard]]
+	auto hasWideIndices() const noexcept -> bool
+	{
+		return options.wideIndices;
+	}
+
+	/**
+	 * Get the size of the memory block needed for a given data capacity.
+	 *
+	 * @param capacity The number of bytes available to packets.
+	 * @return The capacity plus the header overhead.
+	 */
+	[[nodiscard]]
+	static constexpr auto GetMemoryBlockSize(std::size_t capacity) noexcept -> std::size_t
+	{
+		return sizeof(RingBufferHeader) + capacity;
+	}
 
 private:
 	std::span<uint8_t> m_memory {};
 
 protected:
+	[[nodiscard]]
+	auto loadCursor(const RingCursor& cursor, std::memory_order order) const noexcept -> uint64_t
+	{
+		return options.wideIndices ? cursor.wide.load(order) : cursor.narrow.load(order);
+	}
+
+	void storeCursor(RingCursor& cursor, uint64_t value, std::memory_order order) const noexcept
+	{
+		if (options.wideIndices)
+		{
+			cursor.wide.store(value, order);
+		}
+		else
+		{
+			cursor.narrow.store(static_cast<uint32_t>(value), order);
+		}
+	}
+
+	[[nodiscard]]
+	auto getUsedSpace(uint64_t front, uint64_t next) const noexcept -> uint64_t
+	{
+		return next >= front ? next - front : 2u * getCapacity() - (front - next);
+	}
+
+	[[nodiscard]]
+	auto advance(uint64_t cursor, uint64_t count) const noexcept -> uint64_t
+	{
+		const uint64_t toWrap {2u * getCapacity() - cursor};
+		return count >= toWrap ? count - toWrap : cursor + count;
+	}
+
+	[[nodiscard]]
+	auto getOffset(uint64_t cursor) const noexcept -> uint64_t
+	{
+		return cursor >= getCapacity() ? cursor - getCapacity() : cursor;
+	}
+
+	[[nodiscard]]
+	auto getSpan(uint64_t cursor, uint32_t count) noexcept -> RingBufferSpan<uint8_t>;
+
+	[[nodiscard]]
+	auto getSpan(uint64_t cursor, uint32_t count) const noexcept -> RingBufferSpan<const uint8_t>;
+
+	void copyIn(uint64_t cursor, std::span<const uint8_t> source) noexcept;
+	void copyOut(uint64_t cursor, std::span<uint8_t> destination) const noexcept;
+
+	/**
+	 * Copy like copyIn and copyOut, returning the CRC-32C of the bytes copied.
+	 */
+	[[nodiscard]]
+	auto copyInChecksum(uint64_t cursor, std::span<const uint8_t> source) noexcept -> uint32_t;
+
+	[[nodiscard]]
+	auto copyOutChecksum(uint64_t cursor, std::span<uint8_t> destination) const noexcept -> uint32_t;
+
+	[[nodiscard]]
+	auto getChecksum(uint64_t cursor, uint32_t count) const noexcept -> uint32_t;
+	void clear(uint64_t cursor, uint32_t count) noexcept;
+
+	/**
+	 * Add to a statistics counter. Only the owner writes a counter, so there
+	 * is no need for a read-modify-write.
+	 */
+	static void AddToCounter(std::atomic<uint64_t>& counter, uint64_t value) noexcept
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	using Deadline = std::chrono::steady_clock::time_point;
+
+	[[nodiscard]]
+	static auto GetDeadline(std::chrono::nanoseconds timeout) noexcept -> Deadline;
+
+	/**
+	 * Wait for the peer to move its packet count off `expected`, or for the
+	 * deadline.
+	 *
+	 * Spins according to the wait strategy first and sleeps on the count once
+	 * the strategy is exhausted. Callers re-check their condition after every
+	 * call.
+	 *
+	 * @param parked The flag the peer checks after publishing.
+	 * @param waiter The wait state, shared by every call of one wait loop.
+	 * @return False without waiting if the deadline has already passed.
+	 */
+	[[nodiscard]]
+	auto park(std::atomic<uint32_t>& count, uint32_t expected, std::atomic_bool& parked, Deadline deadline, Waiter& waiter) const noexcept -> bool;
+
+	/**
+	 * Publish a new packet count and wake the peer if it is parked on it.
+	 */
+	void storeAndWake(std::atomic<uint32_t>& count, uint32_t value, const std::atomic_bool& parked) const noexcept;
+
 	RingBufferHeader* header {};
 	std::span<uint8_t> data {};
+	RingBufferOptions options {};
 };
 
 #endif  // RING_BUFFER_H_
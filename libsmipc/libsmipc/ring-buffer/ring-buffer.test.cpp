@@ -21,21 +21,43 @@
  * SOFTWARE.
  */
 
+#include <libsmipc/ring-buffer/dekkar-lock.hpp>
+#include <libsmipc/ring-buffer/atomic-spin-lock.hpp>
+#include <libsmipc/ring-buffer/broadcast-ring-buffer.hpp>
+#include <libsmipc/ring-buffer/crc32c.hpp>
+#include <libsmipc/ring-buffer/latency-histogram.hpp>
+#include <libsmipc/ring-buffer/mpsc-ring-buffer.hpp>
 #include <libsmipc/ring-buffer/rx-ring-buffer.hpp>
+#include <libsmipc/ring-buffer/ticket-lock.hpp>
 #include <libsmipc/ring-buffer/tx-ring-buffer.hpp>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#ifdef __linux__
+#	include <sys/mman.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#endif
+
 TEST(ring_buffer, basic_rx_tx)
 {
-	constexpr std::size_t bufferSize {256u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 	RxRingBuffer rx(buffer, bufferSize);
 
@@ -61,9 +83,9 @@ TEST(ring_buffer, basic_rx_tx)
 
 TEST(ring_buffer, basic_tx_throw_on_overflow)
 {
-	constexpr std::size_t bufferSize {128u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 
 	Packet packet {std::vector<uint8_t>(129u)};
@@ -73,9 +95,9 @@ TEST(ring_buffer, basic_tx_throw_on_overflow)
 
 TEST(ring_buffer, basic_rx_tx_1)
 {
-	constexpr std::size_t bufferSize {128u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 	RxRingBuffer rx(buffer, bufferSize);
 
@@ -126,9 +148,9 @@ TEST(ring_buffer, basic_rx_tx_1)
 
 TEST(ring_buffer, basic_rx_tx_3)
 {
-	constexpr std::size_t bufferSize {128u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 	RxRingBuffer rx(buffer, bufferSize);
 
@@ -179,9 +201,9 @@ TEST(ring_buffer, basic_rx_tx_3)
 
 TEST(ring_buffer, basic_rx_tx_4)
 {
-	constexpr std::size_t bufferSize {128u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 	RxRingBuffer rx(buffer, bufferSize);
 
@@ -232,9 +254,9 @@ TEST(ring_buffer, basic_rx_tx_4)
 
 TEST(ring_buffer, basic_rx_tx_5)
 {
-	constexpr std::size_t bufferSize {128u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 	RxRingBuffer rx(buffer, bufferSize);
 
@@ -285,9 +307,9 @@ TEST(ring_buffer, basic_rx_tx_5)
 
 TEST(ring_buffer, basic_rx_tx_13)
 {
-	constexpr std::size_t bufferSize {256u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
 
-	uint8_t buffer[bufferSize] {};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
 	TxRingBuffer tx(buffer, bufferSize);
 	RxRingBuffer rx(buffer, bufferSize);
 
@@ -336,8 +358,1468 @@ TEST(ring_buffer, basic_rx_tx_13)
 	EXPECT_EQ(rxLastPacket.data, std::vector<uint8_t>({243u, 244u, 245u, 246u, 247u, 248u, 249u, 250u, 251u, 252u, 253u, 254u, 255u}));
 }
 
+TEST(ring_buffer, lock_free_rx_tx_wrap)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(108u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	EXPECT_EQ(tx.getMode(), RingBufferMode::LockFree);
+	EXPECT_EQ(rx.getMode(), RingBufferMode::LockFree);
+	EXPECT_TRUE(rx.isEmpty());
+
+	for (std::size_t i = 0u; i < 4096u; ++i)
+	{
+		Packet txPacket {std::vector<uint8_t>({static_cast<uint8_t>(i), static_cast<uint8_t>(i + 1u), static_cast<uint8_t>(i + 2u)})};
+		tx.push(txPacket);
+		tx.push(txPacket);
+
+		EXPECT_EQ(rx.getMessageCount(), 2u);
+
+		EXPECT_EQ(rx.pull().data, txPacket.data);
+		EXPECT_EQ(rx.pull().data, txPacket.data);
+		EXPECT_TRUE(rx.isEmpty());
+	}
+}
+
+TEST(ring_buffer, lock_free_fill_to_capacity)
+{
+	// Exactly four packets with 8 bytes of data fit
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(4u * (kPacketHeaderSize + 8u))};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	const Packet packet {std::vector<uint8_t>(8u, 0xAAu)};
+
+	for (std::size_t i = 0u; i < 4u; ++i)
+	{
+		EXPECT_FALSE(tx.isFull());
+		tx.push(packet);
+	}
+
+	EXPECT_TRUE(tx.isFull());
+	EXPECT_FALSE(rx.isEmpty());
+	EXPECT_EQ(rx.getMessageCount(), 4u);
+	EXPECT_THROW(tx.push(packet), std::overflow_error);
+
+	EXPECT_EQ(rx.pull().data, packet.data);
+	EXPECT_FALSE(tx.isFull());
+	tx.push(packet);
+	EXPECT_TRUE(tx.isFull());
+
+	for (std::size_t i = 0u; i < 4u; ++i)
+	{
+		EXPECT_EQ(rx.pull().data, packet.data);
+	}
+
+	EXPECT_TRUE(rx.isEmpty());
+	EXPECT_THROW(static_cast<void>(rx.pull()), std::runtime_error);
+}
+
+TEST(ring_buffer, lock_free_two_threads)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
+	constexpr uint32_t kPacketCount {100000u};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	std::thread producer([&tx]()
+		{
+			for (uint32_t i = 0u; i < kPacketCount; ++i)
+			{
+				const Packet packet {std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&i), sizeof(i))};
+
+				while (true)
+				{
+					try
+					{
+						tx.push(packet);
+						break;
+					}
+					catch (const std::overflow_error&)
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+		});
+
+	for (uint32_t i = 0u; i < kPacketCount; ++i)
+	{
+		while (rx.isEmpty())
+		{
+			std::this_thread::yield();
+		}
+
+		const auto packet = rx.pull();
+		uint32_t value {};
+		ASSERT_EQ(packet.data.size(), sizeof(value));
+		std::copy_n(packet.data.begin(), sizeof(value), reinterpret_cast<uint8_t*>(&value));
+		ASSERT_EQ(value, i);
+	}
+
+	producer.join();
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, lock_free_message_count)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
+	constexpr uint32_t kPacketCount {100000u};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	std::thread producer([&tx]()
+		{
+			const Packet packet {std::vector<uint8_t>(4u)};
+
+			for (uint32_t i = 0u; i < kPacketCount; ++i)
+			{
+				while (tx.tryPush(packet) == RingBufferStatus::Full)
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+	uint32_t maxMessageCount {};
+
+	for (uint32_t i = 0u; i < kPacketCount; ++i)
+	{
+		Packet packet;
+
+		while (rx.tryPull(packet) != RingBufferStatus::Ok)
+		{
+			maxMessageCount = std::max(maxMessageCount, rx.getMessageCount());
+			std::this_thread::yield();
+		}
+
+		maxMessageCount = std::max(maxMessageCount, rx.getMessageCount());
+	}
+
+	producer.join();
+	EXPECT_LE(maxMessageCount, rx.getCapacity());
+	EXPECT_EQ(rx.getMessageCount(), 0u);
+
+	// The consumer can pull a packet before the producer has counted it, which must not wrap the count around
+	auto& pushCount {reinterpret_cast<RingBuffer::RingBufferHeader*>(buffer)->pushCount};
+	pushCount.fetch_sub(1u);
+	EXPECT_EQ(rx.getMessageCount(), 0u);
+	pushCount.fetch_add(1u);
+}
+
+TEST(ring_buffer, pull_timeout)
+{
+	using namespace std::chrono_literals;
+
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(108u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	const auto start {std::chrono::steady_clock::now()};
+	EXPECT_FALSE(rx.pull(20ms).has_value());
+	EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+	const Packet packet {std::vector<uint8_t>({1u, 2u, 3u})};
+	tx.push(packet);
+
+	const auto rxPacket = rx.pull(0ns);
+	ASSERT_TRUE(rxPacket.has_value());
+	EXPECT_EQ(rxPacket->data, packet.data);
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, try_push_pull)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	Packet rxPacket;
+	EXPECT_EQ(rx.tryPull(rxPacket), RingBufferStatus::Empty);
+	EXPECT_TRUE(rxPacket.data.empty());
+
+	// Each packet takes a header and 16 bytes, three fill the buffer
+	const Packet packet {std::vector<uint8_t>(16u, 0xAAu)};
+	const std::size_t tooLarge {tx.getCapacity() - kPacketHeaderSize + 1u};
+	EXPECT_EQ(tx.tryPush(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(tx.tryPush(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(tx.tryPush(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(tx.tryPush(packet), RingBufferStatus::Full);
+	EXPECT_EQ(tx.tryPush(Packet {std::vector<uint8_t>(tooLarge)}), RingBufferStatus::TooLarge);
+	EXPECT_EQ(tx.tryPush(Packet {}), RingBufferStatus::Ok);
+	EXPECT_EQ(rx.getMessageCount(), 3u);
+
+	// A pulled packet's storage is reused by the next pull
+	EXPECT_EQ(rx.tryPull(rxPacket), RingBufferStatus::Ok);
+	EXPECT_EQ(rxPacket.data, packet.data);
+	const auto* storage = rxPacket.data.data();
+	EXPECT_EQ(rx.tryPull(rxPacket), RingBufferStatus::Ok);
+	EXPECT_EQ(rxPacket.data.data(), storage);
+
+	EXPECT_EQ(tx.tryPush(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(rx.getMessageCount(), 2u);
+	EXPECT_THROW(tx.push(Packet {std::vector<uint8_t>(tooLarge)}), std::overflow_error);
+}
+
+TEST(ring_buffer, push_timeout)
+{
+	using namespace std::chrono_literals;
+
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	// Each packet takes a header and 16 bytes, three fill the buffer
+	const Packet packet {std::vector<uint8_t>(16u, 0xAAu)};
+	EXPECT_TRUE(tx.push(packet, 0ns));
+	EXPECT_TRUE(tx.push(packet, 0ns));
+	EXPECT_TRUE(tx.push(packet, 0ns));
+	EXPECT_FALSE(tx.push(packet, 10ms));
+
+	static_cast<void>(rx.pull());
+	EXPECT_TRUE(tx.push(packet, 10ms));
+	EXPECT_EQ(rx.getMessageCount(), 3u);
+
+	EXPECT_THROW(static_cast<void>(tx.push(Packet {std::vector<uint8_t>(tx.getCapacity())}, 10ms)), std::overflow_error);
+}
+
+TEST(ring_buffer, blocking_two_threads)
+{
+	// Room for about 40 packets, so strategies that never yield still get through quickly on a single core
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(1012u)};
+	constexpr uint32_t kPacketCount {2000u};
+	constexpr auto kForever {std::chrono::nanoseconds::max()};
+
+	for (const auto mode : {RingBufferMode::Locked, RingBufferMode::LockFree})
+	{
+		for (const auto strategy : {WaitStrategy::BusySpin, WaitStrategy::Backoff, WaitStrategy::SpinYield, WaitStrategy::Adaptive})
+		{
+			alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+			TxRingBuffer tx(buffer, bufferSize, RingBufferOptions {.mode = mode, .waitStrategy = strategy});
+			RxRingBuffer rx(buffer, bufferSize, RingBufferOptions {.mode = mode, .waitStrategy = strategy});
+
+			// Neither side polls, both wait on the other's cursor when they run out
+			std::thread producer([&tx, kForever]()
+				{
+					for (uint32_t i = 0u; i < kPacketCount; ++i)
+					{
+						const Packet packet {std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&i), sizeof(i))};
+						ASSERT_TRUE(tx.push(packet, kForever));
+					}
+				});
+
+			for (uint32_t i = 0u; i < kPacketCount; ++i)
+			{
+				const auto packet = rx.pull(kForever);
+				ASSERT_TRUE(packet.has_value());
+
+				uint32_t value {};
+				ASSERT_EQ(packet->data.size(), sizeof(value));
+				std::copy_n(packet->data.begin(), sizeof(value), reinterpret_cast<uint8_t*>(&value));
+				ASSERT_EQ(value, i);
+			}
+
+			producer.join();
+			EXPECT_TRUE(rx.isEmpty());
+		}
+	}
+}
+
+TEST(ring_buffer, wait_strategy)
+{
+	const auto countUntilExhausted = [](WaitStrategy strategy)
+	{
+		Waiter waiter {strategy};
+		uint32_t count {0u};
+
+		while (! waiter.isExhausted() && count < 1000u)
+		{
+			waiter.wait();
+			++count;
+		}
+
+		return count;
+	};
+
+	EXPECT_EQ(countUntilExhausted(WaitStrategy::BusySpin), 1000u);
+	EXPECT_EQ(countUntilExhausted(WaitStrategy::Backoff), 11u);
+	EXPECT_EQ(countUntilExhausted(WaitStrategy::SpinYield), 96u);
+	EXPECT_EQ(countUntilExhausted(WaitStrategy::Adaptive), 112u);
+
+	Waiter waiter {WaitStrategy::Backoff};
+
+	for (uint32_t i = 0u; i < 11u; ++i)
+	{
+		waiter.wait();
+	}
+
+	EXPECT_TRUE(waiter.isExhausted());
+	waiter.reset();
+	EXPECT_FALSE(waiter.isExhausted());
+}
+
+TEST(ring_buffer, spin_locks)
+{
+	std::atomic_bool flag {false};
+	AtomicSpinLock spinLock {flag};
+	AtomicSpinLock otherSpinLock {flag};
+
+	EXPECT_TRUE(spinLock.tryLock());
+	EXPECT_FALSE(otherSpinLock.tryLock());
+	spinLock.unlock();
+	EXPECT_TRUE(otherSpinLock.tryLock());
+	otherSpinLock.unlock();
+
+	std::atomic<uint32_t> next {};
+	std::atomic<uint32_t> serving {};
+	TicketLock ticketLock {next, serving};
+	TicketLock otherTicketLock {next, serving};
+
+	ticketLock.lock();
+	EXPECT_FALSE(otherTicketLock.tryLock());
+	ticketLock.unlock();
+	EXPECT_TRUE(otherTicketLock.tryLock());
+	otherTicketLock.unlock();
+	EXPECT_EQ(next.load(), serving.load());
+}
+
+TEST(ring_buffer, lock_policies)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(1012u)};
+	constexpr uint32_t kPacketCount {2000u};
+	constexpr auto kForever {std::chrono::nanoseconds::max()};
+
+	std::vector<LockPolicy> policies {LockPolicy::Dekker, LockPolicy::TestAndTestAndSet, LockPolicy::Ticket};
+#ifdef __linux__
+	policies.push_back(LockPolicy::RobustMutex);
+#endif
+
+	for (const auto policy : policies)
+	{
+		const RingBufferOptions options {.statistics = true, .lockPolicy = policy};
+
+		alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+		TxRingBuffer tx(buffer, bufferSize, options);
+		RxRingBuffer rx(buffer, bufferSize, options);
+
+		std::thread producer([&tx, kForever]()
+			{
+				for (uint32_t i = 0u; i < kPacketCount; ++i)
+				{
+					const Packet packet {std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&i), sizeof(i))};
+					ASSERT_TRUE(tx.push(packet, kForever));
+				}
+			});
+
+		for (uint32_t i = 0u; i < kPacketCount; ++i)
+		{
+			const auto packet = rx.pull(kForever);
+			ASSERT_TRUE(packet.has_value());
+
+			uint32_t value {};
+			std::copy_n(packet->data.begin(), sizeof(value), reinterpret_cast<uint8_t*>(&value));
+			ASSERT_EQ(value, i);
+		}
+
+		producer.join();
+		EXPECT_TRUE(rx.isEmpty());
+		EXPECT_EQ(rx.getStatistics().pulledPackets, kPacketCount);
+
+		// Attaching with another policy would leave the two sides taking different locks
+		const auto otherPolicy {policy == LockPolicy::Dekker ? LockPolicy::Ticket : LockPolicy::Dekker};
+		EXPECT_THROW(RxRingBuffer(buffer, bufferSize, RingBufferOptions {.lockPolicy = otherPolicy}), std::invalid_argument);
+	}
+}
+
+#ifdef __linux__
+TEST(ring_buffer, robust_mutex_owner_died)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(256u)};
+	const RingBufferOptions options {.lockPolicy = LockPolicy::RobustMutex};
+
+	void* memory {mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0)};
+	ASSERT_NE(memory, MAP_FAILED);
+	auto* buffer {static_cast<uint8_t*>(memory)};
+
+	TxRingBuffer tx(buffer, bufferSize, options);
+
+	// The child dies holding the lock, the next side to take it recovers it
+	const pid_t child {fork()};
+	ASSERT_NE(child, -1);
+
+	if (child == 0)
+	{
+		pthread_mutex_lock(&reinterpret_cast<RingBuffer::RingBufferHeader*>(buffer)->mutex);
+		_exit(0);
+	}
+
+	int status {};
+	ASSERT_EQ(waitpid(child, &status, 0), child);
+
+	RxRingBuffer rx(buffer, bufferSize, options);
+	const uint8_t data[] {1u, 2u, 3u};
+	Packet packet {};
+
+	EXPECT_EQ(tx.tryPush(Packet {data}), RingBufferStatus::Ok);
+	EXPECT_EQ(rx.tryPull(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(packet.data.size(), sizeof(data));
+	EXPECT_EQ(rx.tryPull(packet), RingBufferStatus::Empty);
+
+	munmap(memory, bufferSize);
+}
+#endif
+
+TEST(ring_buffer, header_layout)
+{
+	using Header = RingBuffer::RingBufferHeader;
+
+	EXPECT_EQ(sizeof(Header) % kCacheLineSize, 0u);
+	EXPECT_NE(offsetof(Header, next) / kCacheLineSize, offsetof(Header, front) / kCacheLineSize);
+	EXPECT_NE(offsetof(Header, version) / kCacheLineSize, offsetof(Header, next) / kCacheLineSize);
+	EXPECT_NE(offsetof(Header, version) / kCacheLineSize, offsetof(Header, front) / kCacheLineSize);
+	EXPECT_EQ(offsetof(Header, next) / kCacheLineSize, offsetof(Header, txWaiting) / kCacheLineSize);
+	EXPECT_EQ(offsetof(Header, front) / kCacheLineSize, offsetof(Header, rxWaiting) / kCacheLineSize);
+	EXPECT_EQ(offsetof(Header, next) / kCacheLineSize, offsetof(Header, txLockSpins) / kCacheLineSize);
+	EXPECT_EQ(offsetof(Header, front) / kCacheLineSize, offsetof(Header, rxLockSpins) / kCacheLineSize);
+	EXPECT_NE(offsetof(Header, spinLock) / kCacheLineSize, offsetof(Header, version) / kCacheLineSize);
+	EXPECT_NE(offsetof(Header, spinLock) / kCacheLineSize, offsetof(Header, next) / kCacheLineSize);
+	EXPECT_NE(offsetof(Header, spinLock) / kCacheLineSize, offsetof(Header, front) / kCacheLineSize);
+
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(256u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+
+	EXPECT_EQ(tx.getMemoryBlockSize(), bufferSize);
+	EXPECT_EQ(tx.getCapacity(), 256u);
+	EXPECT_EQ(reinterpret_cast<const Header*>(buffer)->version.load(), kRingBufferVersion);
+}
+
+TEST(ring_buffer, header_validation)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(256u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize + kCacheLineSize] {};
+
+	EXPECT_THROW(TxRingBuffer(buffer + 4u, bufferSize), std::invalid_argument);
+
+	TxRingBuffer tx(buffer, bufferSize);
+	EXPECT_THROW(RxRingBuffer(buffer, bufferSize - kCacheLineSize), std::invalid_argument);
+
+	reinterpret_cast<RingBuffer::RingBufferHeader*>(buffer)->version.store(kRingBufferVersion + 1u);
+	EXPECT_THROW(RxRingBuffer(buffer, bufferSize), std::invalid_argument);
+}
+
+TEST(ring_buffer, concurrent_setup)
+{
+	using Header = RingBuffer::RingBufferHeader;
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(256u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	auto* header {reinterpret_cast<Header*>(buffer)};
+
+	// A side attaching while the peer lays out the header waits for the layout it ends up with
+	header->version.store(kRingBufferInitialising);
+
+	std::thread peer([header]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			header->capacity = 256u;
+			header->version.store(kRingBufferVersion | kRingBufferWideIndexTag, std::memory_order_release);
+		});
+
+	RxRingBuffer rx(buffer, bufferSize);
+	peer.join();
+	EXPECT_TRUE(rx.hasWideIndices());
+
+	// Both sides constructed at once agree on one layout
+	for (uint32_t i = 0u; i < 200u; ++i)
+	{
+		std::fill_n(buffer, sizeof(Header), uint8_t {});
+		std::atomic_bool start {false};
+		bool txWide {};
+
+		std::thread producer([&buffer, &start, &txWide]()
+			{
+				while (! start.load())
+				{
+				}
+
+				const TxRingBuffer tx(buffer, bufferSize, RingBufferOptions {.wideIndices = true});
+				txWide = tx.hasWideIndices();
+			});
+
+		start.store(true);
+		const RxRingBuffer racer(buffer, bufferSize);
+		producer.join();
+
+		ASSERT_EQ(racer.hasWideIndices(), txWide);
+		ASSERT_NE(header->version.load(), kRingBufferInitialising);
+	}
+
+	// A header nobody finishes laying out is given up on
+	header->version.store(kRingBufferInitialising);
+	EXPECT_THROW(RxRingBuffer(buffer, bufferSize), std::runtime_error);
+}
+
+TEST(ring_buffer, wide_indices)
+{
+	// Room for about 40 packets, the producer has to wait for the consumer
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(1012u)};
+	constexpr uint32_t kPacketCount {2000u};
+	constexpr auto kForever {std::chrono::nanoseconds::max()};
+
+	for (const bool wideIndices : {false, true})
+	{
+		alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+		TxRingBuffer tx(buffer, bufferSize, RingBufferOptions {.wideIndices = wideIndices});
+
+		// The consumer follows the layout in the header
+		RxRingBuffer rx(buffer, bufferSize);
+
+		const uint32_t version {reinterpret_cast<const RingBuffer::RingBufferHeader*>(buffer)->version.load()};
+		EXPECT_EQ(version, wideIndices ? kRingBufferVersion | kRingBufferWideIndexTag : kRingBufferVersion);
+		EXPECT_EQ(tx.hasWideIndices(), wideIndices);
+		EXPECT_EQ(rx.hasWideIndices(), wideIndices);
+
+		std::thread producer([&tx, kForever]()
+			{
+				for (uint32_t i = 0u; i < kPacketCount; ++i)
+				{
+					const Packet packet {std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&i), sizeof(i))};
+					ASSERT_TRUE(tx.push(packet, kForever));
+				}
+			});
+
+		for (uint32_t i = 0u; i < kPacketCount; ++i)
+		{
+			const auto packet = rx.pull(kForever);
+			ASSERT_TRUE(packet.has_value());
+
+			uint32_t value {};
+			std::copy_n(packet->data.begin(), sizeof(value), reinterpret_cast<uint8_t*>(&value));
+			ASSERT_EQ(value, i);
+		}
+
+		producer.join();
+		EXPECT_TRUE(rx.isEmpty());
+		EXPECT_EQ(rx.getMessageCount(), 0u);
+	}
+}
+
+#ifdef __linux__
+TEST(ring_buffer, large_ring)
+{
+	// Only the pages touched are backed, the rest of the ring stays virtual
+	constexpr uint64_t kCapacity {5ull * 1024u * 1024u * 1024u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(kCapacity)};
+
+	void* memory {mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)};
+	ASSERT_NE(memory, MAP_FAILED);
+	auto* buffer {static_cast<uint8_t*>(memory)};
+
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	EXPECT_TRUE(tx.hasWideIndices());
+	EXPECT_EQ(tx.getCapacity(), kCapacity);
+
+	// Start just short of the end of the cursor range, so the packets cross it and the end of the data
+	auto* header {reinterpret_cast<RingBuffer::RingBufferHeader*>(buffer)};
+	header->front.wide.store(2u * kCapacity - 32u);
+	header->next.wide.store(2u * kCapacity - 32u);
+
+	for (uint32_t i = 0u; i < 4u; ++i)
+	{
+		const std::vector<uint8_t> data(40u + i, static_cast<uint8_t>(i));
+		tx.push(Packet {data});
+
+		const auto packet = rx.pull();
+		EXPECT_EQ(packet.data, data);
+	}
+
+	EXPECT_LT(header->front.wide.load(), 4096u);
+	EXPECT_TRUE(rx.isEmpty());
+
+	munmap(memory, bufferSize);
+}
+#endif
+
+TEST(ring_buffer, reserve_commit)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(108u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	for (std::size_t i = 0u; i < 4096u; ++i)
+	{
+		const std::size_t size {1u + i % 13u};
+		auto region = tx.reserve(size);
+		EXPECT_EQ(region.size(), size);
+
+		std::size_t value {i};
+		for (auto& byte : region.first)
+		{
+			byte = static_cast<uint8_t>(value++);
+		}
+		for (auto& byte : region.second)
+		{
+			byte = static_cast<uint8_t>(value++);
+		}
+
+		EXPECT_TRUE(rx.isEmpty());
+		tx.commit();
+		EXPECT_EQ(rx.getMessageCount(), 1u);
+
+		const auto rxPacket = rx.pull();
+		ASSERT_EQ(rxPacket.data.size(), size);
+
+		for (std::size_t j = 0u; j < size; ++j)
+		{
+			EXPECT_EQ(rxPacket.data[j], static_cast<uint8_t>(i + j));
+		}
+	}
+}
+
+TEST(ring_buffer, reserve_commit_wrap)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(kPacketHeaderSize + 60u + kPacketHeaderSize + 8u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	// Move the cursors so the next header fits and its payload straddles the end of the buffer
+	tx.push(Packet {std::vector<uint8_t>(60u)});
+	static_cast<void>(rx.pull());
+
+	auto region = tx.reserve(40u);
+	EXPECT_FALSE(region.isContiguous());
+	EXPECT_EQ(region.first.size(), 8u);
+	EXPECT_EQ(region.second.size(), 32u);
+
+	std::fill(region.first.begin(), region.first.end(), 1u);
+	std::fill(region.second.begin(), region.second.end(), 2u);
+	tx.commit(10u);
+
+	const auto rxPacket = rx.pull();
+	EXPECT_EQ(rxPacket.data, std::vector<uint8_t>({1u, 1u, 1u, 1u, 1u, 1u, 1u, 1u, 2u, 2u}));
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, reserve_misuse)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(108u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	EXPECT_THROW(tx.commit(), std::logic_error);
+	EXPECT_THROW(static_cast<void>(tx.reserve(109u)), std::overflow_error);
+
+	static_cast<void>(tx.reserve(8u));
+	EXPECT_THROW(static_cast<void>(tx.reserve(8u)), std::logic_error);
+	EXPECT_THROW(tx.commit(9u), std::invalid_argument);
+
+	tx.cancel();
+	EXPECT_THROW(tx.commit(), std::logic_error);
+	EXPECT_TRUE(rx.isEmpty());
+
+	static_cast<void>(tx.reserve(8u));
+	tx.commit(0u);
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, push_while_reserved)
+{
+	using namespace std::chrono_literals;
+
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(108u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	auto region = tx.reserve(4u);
+	std::fill(region.first.begin(), region.first.end(), 7u);
+
+	// Every push path would write over the reserved space
+	const Packet packet {std::vector<uint8_t>(4u, 1u)};
+	const std::vector<Packet> packets {packet};
+	const std::vector<std::span<const uint8_t>> payloads {packet.data};
+	EXPECT_THROW(tx.push(packet), std::logic_error);
+	EXPECT_THROW(static_cast<void>(tx.tryPush(packet)), std::logic_error);
+	EXPECT_THROW(static_cast<void>(tx.push(packet, 0ns)), std::logic_error);
+	EXPECT_THROW(static_cast<void>(tx.pushBatch(packets)), std::logic_error);
+	EXPECT_THROW(static_cast<void>(tx.pushBatch(payloads)), std::logic_error);
+	EXPECT_TRUE(rx.isEmpty());
+
+	tx.commit();
+	tx.push(packet);
+	EXPECT_EQ(rx.pull().data, std::vector<uint8_t>(4u, 7u));
+	EXPECT_EQ(rx.pull().data, packet.data);
+}
+
+TEST(ring_buffer, peek_release)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(108u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	EXPECT_THROW(static_cast<void>(rx.peek()), std::runtime_error);
+	EXPECT_THROW(rx.release(), std::runtime_error);
+
+	for (std::size_t i = 0u; i < 4096u; ++i)
+	{
+		const Packet txPacket {std::vector<uint8_t>(1u + i % 29u, static_cast<uint8_t>(i))};
+		tx.push(txPacket);
+
+		const auto view = rx.peek();
+		EXPECT_EQ(view.header.size, txPacket.data.size());
+		EXPECT_EQ(view.header.transferId, txPacket.header.transferId);
+		EXPECT_EQ(view.data.size(), txPacket.data.size());
+
+		std::vector<uint8_t> rxData(view.data.first.begin(), view.data.first.end());
+		rxData.insert(rxData.end(), view.data.second.begin(), view.data.second.end());
+		EXPECT_EQ(rxData, txPacket.data);
+
+		// Peeking does not consume
+		EXPECT_EQ(rx.getMessageCount(), 1u);
+		EXPECT_EQ(rx.peek().data.first.data(), view.data.first.data());
+
+		rx.release();
+		EXPECT_TRUE(rx.isEmpty());
+	}
+}
+
+TEST(ring_buffer, push_batch)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	for (std::size_t i = 0u; i < 1024u; ++i)
+	{
+		const std::vector<Packet> packets {
+			Packet {std::vector<uint8_t>({static_cast<uint8_t>(i), 1u})},
+			Packet {},
+			Packet {std::vector<uint8_t>({static_cast<uint8_t>(i), 2u, 3u})},
+			Packet {std::vector<uint8_t>(41u, static_cast<uint8_t>(i))},
+		};
+
+		// The two small packets fit, the large one does not until one is pulled
+		EXPECT_EQ(tx.pushBatch(packets), 3u);
+		EXPECT_EQ(rx.getMessageCount(), 2u);
+		EXPECT_EQ(tx.pushBatch(std::span(packets).subspan(3u)), 0u);
+
+		EXPECT_EQ(rx.pull().data, packets[0].data);
+		EXPECT_EQ(tx.pushBatch(std::span(packets).subspan(3u)), 1u);
+		EXPECT_EQ(rx.pull().data, packets[2].data);
+		EXPECT_EQ(rx.pull().data, packets[3].data);
+		EXPECT_TRUE(rx.isEmpty());
+	}
+
+	// A packet that can never fit stops the batch, and throws once a retry starts with it
+	const std::vector<Packet> packets {
+		Packet {std::vector<uint8_t>(4u)},
+		Packet {std::vector<uint8_t>(tx.getCapacity())},
+		Packet {std::vector<uint8_t>(4u)},
+	};
+
+	EXPECT_EQ(tx.pushBatch(packets), 1u);
+	EXPECT_THROW(static_cast<void>(tx.pushBatch(std::span(packets).subspan(1u))), std::overflow_error);
+	EXPECT_EQ(rx.getMessageCount(), 1u);
+	EXPECT_EQ(tx.pushBatch(std::span(packets).subspan(2u)), 1u);
+}
+
+TEST(ring_buffer, push_batch_gather)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	const std::vector<uint8_t> payload1 {1u, 2u, 3u};
+	const std::vector<uint8_t> payload2(237u);
+	const std::vector<uint8_t> payload3 {4u, 5u, 6u, 7u, 8u};
+	const std::vector<std::span<const uint8_t>> payloads {payload1, payload3, payload2};
+
+	EXPECT_EQ(tx.pushBatch(payloads), 2u);
+	EXPECT_EQ(rx.getMessageCount(), 2u);
+
+	const auto rxPacket1 = rx.pull();
+	const auto rxPacket2 = rx.pull();
+	EXPECT_EQ(rxPacket1.data, payload1);
+	EXPECT_EQ(rxPacket2.data, payload3);
+	EXPECT_NE(rxPacket1.header.transferId, rxPacket2.header.transferId);
+	EXPECT_TRUE(rx.isEmpty());
+
+	EXPECT_THROW(static_cast<void>(tx.pushBatch(std::span(payloads).subspan(2u))), std::overflow_error);
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, drain)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	EXPECT_EQ(rx.drain([](const PacketView&) {}), 0u);
+
+	for (std::size_t i = 0u; i < 1024u; ++i)
+	{
+		for (std::size_t j = 0u; j < 5u; ++j)
+		{
+			tx.push(Packet {std::vector<uint8_t>(1u + (i + j) % 7u, static_cast<uint8_t>(i + j))});
+		}
+
+		std::vector<uint8_t> firstBytes;
+		const auto handler = [&firstBytes](const PacketView& view)
+		{
+			firstBytes.push_back(view.data.first.front());
+			EXPECT_EQ(view.data.size(), view.header.size);
+		};
+
+		EXPECT_EQ(rx.drain(handler, 2u), 2u);
+		EXPECT_EQ(rx.getMessageCount(), 3u);
+		EXPECT_EQ(rx.drain(handler), 3u);
+		EXPECT_TRUE(rx.isEmpty());
+
+		EXPECT_EQ(firstBytes, std::vector<uint8_t>({static_cast<uint8_t>(i), static_cast<uint8_t>(i + 1u), static_cast<uint8_t>(i + 2u), static_cast<uint8_t>(i + 3u), static_cast<uint8_t>(i + 4u)}));
+	}
+}
+
+TEST(ring_buffer, drain_handler_throws)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(236u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	for (uint8_t i = 0u; i < 4u; ++i)
+	{
+		tx.push(Packet {std::vector<uint8_t>({i})});
+	}
+
+	std::size_t handled {0u};
+	const auto handler = [&handled](const PacketView& view)
+	{
+		if (view.data.first.front() == 2u)
+		{
+			throw std::runtime_error("Handler failed");
+		}
+
+		++handled;
+	};
+
+	EXPECT_THROW(rx.drain(handler), std::runtime_error);
+	EXPECT_EQ(handled, 2u);
+	EXPECT_EQ(rx.getMessageCount(), 2u);
+	EXPECT_EQ(rx.pull().data, std::vector<uint8_t>({2u}));
+	EXPECT_EQ(rx.drain(handler), 1u);
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, dekker_lock_two_threads)
+{
+	constexpr uint32_t kIterations {20000u};
+
+	std::atomic_bool txWaiting {false};
+	std::atomic_bool rxWaiting {false};
+	std::atomic_bool turn {false};
+
+	// The two sides share turn and pass opposite senses for it
+	DekkarLock txLock {txWaiting, rxWaiting, turn, false, WaitStrategy::SpinYield};
+	DekkarLock rxLock {rxWaiting, txWaiting, turn, true, WaitStrategy::SpinYield};
+	uint32_t counter {0u};
+
+	const auto increment = [&counter](DekkarLock& lock)
+	{
+		for (uint32_t i = 0u; i < kIterations; ++i)
+		{
+			lock.lock();
+			++counter;
+			lock.unlock();
+		}
+	};
+
+	std::thread rx(increment, std::ref(rxLock));
+	increment(txLock);
+	rx.join();
+
+	EXPECT_EQ(counter, 2u * kIterations);
+
+	// tryLock fails while the other side holds the lock and leaves no trace
+	rxLock.lock();
+	EXPECT_FALSE(txLock.tryLock());
+	rxLock.unlock();
+	EXPECT_TRUE(txLock.tryLock());
+	txLock.unlock();
+}
+
 int main(int argc, char** argv)
 {
 	testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
 }
+
+TEST(ring_buffer, mpsc_rx_tx_wrap)
+{
+	constexpr std::size_t bufferSize {MpscRingBuffer::GetMemoryBlockSize(2u * (kPacketHeaderSize + 8u) + 8u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	MpscTxRingBuffer tx1(buffer, bufferSize);
+	MpscTxRingBuffer tx2(buffer, bufferSize);
+	MpscRxRingBuffer rx(buffer, bufferSize);
+
+	EXPECT_TRUE(rx.isEmpty());
+	EXPECT_THROW((void)rx.pull(), std::runtime_error);
+
+	// Two packets of 8 bytes fit with 8 to spare, so the cursors wrap every few packets
+	std::vector<uint8_t> data(8u);
+
+	for (uint8_t i = 0u; i < 10u; ++i)
+	{
+		std::fill(data.begin(), data.end(), i);
+		auto& tx {i % 2u == 0u ? tx1 : tx2};
+		EXPECT_EQ(tx.tryPush(Packet(data)), RingBufferStatus::Ok);
+
+		const auto packet {rx.pull()};
+		EXPECT_EQ(packet.data, data);
+		EXPECT_TRUE(rx.isEmpty());
+	}
+
+	EXPECT_EQ(tx1.tryPush(Packet(data)), RingBufferStatus::Ok);
+	EXPECT_EQ(tx2.tryPush(Packet(data)), RingBufferStatus::Ok);
+	EXPECT_EQ(tx1.tryPush(Packet(data)), RingBufferStatus::Full);
+	EXPECT_EQ(tx1.tryPush(Packet(std::vector<uint8_t>(tx1.getCapacity()))), RingBufferStatus::TooLarge);
+	EXPECT_THROW(tx1.push(Packet(std::vector<uint8_t>(tx1.getCapacity()))), std::overflow_error);
+
+	// The MPSC layout is not interchangeable with the single producer one
+	EXPECT_THROW(RxRingBuffer(buffer, bufferSize), std::invalid_argument);
+}
+
+TEST(ring_buffer, mpsc_producers)
+{
+	constexpr std::size_t bufferSize {MpscRingBuffer::GetMemoryBlockSize(1024u)};
+	constexpr uint32_t kProducerCount {4u};
+	constexpr uint32_t kPacketCount {2000u};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	MpscRxRingBuffer rx(buffer, bufferSize);
+	std::vector<std::thread> producers;
+
+	// Half the producers wait for space, the other half retry on Full
+	for (uint32_t id = 0u; id < kProducerCount; ++id)
+	{
+		producers.emplace_back([&buffer, id]()
+			{
+				MpscTxRingBuffer tx(buffer, bufferSize);
+
+				for (uint32_t i = 0u; i < kPacketCount; ++i)
+				{
+					const uint32_t value[2] {id, i};
+					const Packet packet {std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(value), sizeof(value))};
+
+					if (id % 2u == 0u)
+					{
+						tx.push(packet);
+						continue;
+					}
+
+					while (tx.tryPush(packet) == RingBufferStatus::Full)
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+	}
+
+	// Packets from different producers interleave, but each producer's stay in order
+	std::vector<uint32_t> expected(kProducerCount, 0u);
+	Packet packet;
+
+	for (uint32_t received = 0u; received < kProducerCount * kPacketCount;)
+	{
+		if (rx.tryPull(packet) != RingBufferStatus::Ok)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		uint32_t value[2] {};
+		ASSERT_EQ(packet.data.size(), sizeof(value));
+		std::copy_n(packet.data.begin(), sizeof(value), reinterpret_cast<uint8_t*>(value));
+		ASSERT_LT(value[0], kProducerCount);
+		ASSERT_EQ(value[1], expected[value[0]]++);
+		++received;
+	}
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	EXPECT_TRUE(rx.isEmpty());
+}
+
+TEST(ring_buffer, broadcast_fan_out)
+{
+	constexpr std::size_t bufferSize {BroadcastRingBuffer::GetMemoryBlockSize(256u)};
+	alignas(kCacheLineSize) static uint8_t buffer[bufferSize] {};
+	BroadcastTxRingBuffer tx(buffer, bufferSize);
+
+	{
+		BroadcastRxRingBuffer rx1(buffer, bufferSize);
+		BroadcastRxRingBuffer rx2(buffer, bufferSize);
+		EXPECT_EQ(tx.getSubscriberCount(), 2u);
+
+		const std::vector<uint8_t> data {1, 2, 3, 4, 5};
+		tx.push(Packet(data));
+
+		// Subscribers only see what is published after they join
+		BroadcastRxRingBuffer rx3(buffer, bufferSize);
+		EXPECT_TRUE(rx3.isEmpty());
+		EXPECT_EQ(tx.getMaxLag(), kPacketHeaderSize + AlignedSize(5u));
+
+		EXPECT_EQ(rx1.pull().data, data);
+		EXPECT_EQ(rx2.pull().data, data);
+		EXPECT_TRUE(rx1.isEmpty());
+		EXPECT_THROW((void)rx2.pull(), std::runtime_error);
+		EXPECT_EQ(tx.getMaxLag(), 0u);
+	}
+
+	EXPECT_EQ(tx.getSubscriberCount(), 0u);
+	EXPECT_EQ(tx.tryPush(Packet(std::vector<uint8_t>(256u))), RingBufferStatus::TooLarge);
+
+	// Slots are handed back when a subscriber goes away
+	std::vector<std::unique_ptr<BroadcastRxRingBuffer>> subscribers;
+
+	for (std::size_t i = 0u; i < kBroadcastMaxSubscribers; ++i)
+	{
+		subscribers.push_back(std::make_unique<BroadcastRxRingBuffer>(buffer, bufferSize));
+	}
+
+	EXPECT_THROW(BroadcastRxRingBuffer(buffer, bufferSize), std::runtime_error);
+	subscribers.pop_back();
+	EXPECT_NO_THROW(BroadcastRxRingBuffer(buffer, bufferSize));
+}
+
+TEST(ring_buffer, broadcast_overrun)
+{
+	constexpr std::size_t bufferSize {BroadcastRingBuffer::GetMemoryBlockSize(128u)};
+	alignas(kCacheLineSize) static uint8_t buffer[bufferSize] {};
+	BroadcastTxRingBuffer tx(buffer, bufferSize);
+	BroadcastRxRingBuffer fast(buffer, bufferSize);
+	BroadcastRxRingBuffer slow(buffer, bufferSize);
+
+	// 28 bytes per packet, so the writer laps the slow reader after 5 packets
+	for (uint32_t i = 0u; i < 10u; ++i)
+	{
+		const uint32_t value[2] {i, i};
+		tx.push(Packet(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(value), sizeof(value))));
+
+		const auto packet {fast.pull()};
+		EXPECT_EQ(packet.data[0], i);
+	}
+
+	Packet packet;
+	EXPECT_EQ(slow.tryPull(packet), RingBufferStatus::Overrun);
+	EXPECT_EQ(slow.getOverrunCount(), 1u);
+	EXPECT_EQ(fast.getOverrunCount(), 0u);
+
+	// The slow reader resumes from the latest packet
+	EXPECT_EQ(slow.tryPull(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(packet.data[0], 9u);
+	EXPECT_EQ(slow.tryPull(packet), RingBufferStatus::Empty);
+
+	for (uint32_t i = 10u; i < 20u; ++i)
+	{
+		tx.push(Packet(std::vector<uint8_t>(8u, static_cast<uint8_t>(i))));
+	}
+
+	EXPECT_THROW((void)slow.pull(), std::out_of_range);
+	EXPECT_EQ(slow.pull().data[0], 19u);
+}
+
+TEST(ring_buffer, broadcast_two_threads)
+{
+	constexpr std::size_t bufferSize {BroadcastRingBuffer::GetMemoryBlockSize(512u)};
+	constexpr uint32_t kPacketCount {200000u};
+
+	alignas(kCacheLineSize) static uint8_t buffer[bufferSize] {};
+	BroadcastTxRingBuffer tx(buffer, bufferSize);
+	BroadcastRxRingBuffer rx(buffer, bufferSize);
+
+	// Payloads are a counter repeated, so a torn read shows up as a mismatch
+	std::thread writer([&tx]()
+		{
+			std::array<uint32_t, 8u> payload {};
+
+			for (uint32_t i = 1u; i <= kPacketCount; ++i)
+			{
+				payload.fill(i);
+				tx.push(Packet(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(payload.data()), sizeof(payload))));
+			}
+		});
+
+	uint32_t last {0u};
+	uint64_t overruns {0u};
+	bool skipped {false};
+	Packet packet;
+
+	while (last != kPacketCount)
+	{
+		const auto status {rx.tryPull(packet)};
+
+		if (status == RingBufferStatus::Empty)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (status == RingBufferStatus::Overrun)
+		{
+			++overruns;
+			skipped = true;
+			continue;
+		}
+
+		std::array<uint32_t, 8u> payload {};
+		ASSERT_EQ(packet.data.size(), sizeof(payload));
+		std::copy_n(packet.data.begin(), sizeof(payload), reinterpret_cast<uint8_t*>(payload.data()));
+		ASSERT_TRUE(std::ranges::all_of(payload, [&payload](uint32_t value) { return value == payload[0]; }));
+
+		// Without an overrun nothing may be skipped
+		ASSERT_GT(payload[0], last);
+		ASSERT_TRUE(payload[0] == last + 1u || skipped);
+		last = payload[0];
+		skipped = false;
+	}
+
+	writer.join();
+	EXPECT_EQ(overruns, rx.getOverrunCount());
+}
+
+TEST(ring_buffer, packet_buffer)
+{
+	const std::vector<uint8_t> small(kPacketInlineCapacity, 0x11u);
+	const std::vector<uint8_t> large(kPacketInlineCapacity + 1u, 0x22u);
+
+	PacketBuffer inlineBuffer {small};
+	EXPECT_TRUE(inlineBuffer.isInline());
+	EXPECT_EQ(inlineBuffer, small);
+
+	PacketBuffer heapBuffer {large};
+	EXPECT_FALSE(heapBuffer.isInline());
+	EXPECT_EQ(heapBuffer, large);
+
+	// Growing keeps the contents, moving steals the heap block
+	inlineBuffer.resize(large.size());
+	EXPECT_FALSE(inlineBuffer.isInline());
+	EXPECT_TRUE(std::equal(small.begin(), small.end(), inlineBuffer.begin()));
+
+	const auto* storage {heapBuffer.data()};
+	PacketBuffer moved {std::move(heapBuffer)};
+	EXPECT_EQ(moved.data(), storage);
+	EXPECT_EQ(moved, large);
+	EXPECT_TRUE(heapBuffer.empty());
+
+	PacketBuffer copied {moved};
+	EXPECT_NE(copied.data(), moved.data());
+	EXPECT_EQ(copied, moved);
+
+	copied = PacketBuffer {small};
+	EXPECT_EQ(copied, small);
+
+	// Released blocks are handed out again instead of hitting the heap
+	PacketBufferPool::Trim();
+	const auto block {PacketBufferPool::Acquire(1000u)};
+	EXPECT_GE(block.capacity, 1000u);
+	PacketBufferPool::Release(block);
+	const auto reused {PacketBufferPool::Acquire(600u)};
+	EXPECT_EQ(reused.data, block.data);
+	PacketBufferPool::Release(reused);
+	EXPECT_EQ(PacketBufferPool::GetPooledSize(), reused.capacity);
+
+	// A burst of large blocks is only kept up to the pool's capacity
+	PacketBufferPool::Trim();
+	std::vector<PacketBufferPool::Block> burst;
+
+	for (std::size_t i = 0u; i < 4u; ++i)
+	{
+		burst.push_back(PacketBufferPool::Acquire(kPacketPoolCapacity / 2u));
+	}
+
+	burst.push_back(PacketBufferPool::Acquire(16u * 1024u * 1024u));
+
+	for (const auto& large : burst)
+	{
+		PacketBufferPool::Release(large);
+	}
+
+	EXPECT_EQ(PacketBufferPool::GetPooledSize(), kPacketPoolCapacity);
+	PacketBufferPool::Trim();
+	EXPECT_EQ(PacketBufferPool::GetPooledSize(), 0u);
+}
+
+TEST(ring_buffer, packet_storage_reuse)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(4096u)};
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, RingBufferMode::LockFree);
+	RxRingBuffer rx(buffer, bufferSize, RingBufferMode::LockFree);
+
+	const std::vector<uint8_t> small(15u, 0x33u);
+	const std::vector<uint8_t> large(1024u, 0x44u);
+
+	tx.push(Packet(small));
+	auto packet {rx.pull()};
+	EXPECT_TRUE(packet.data.isInline());
+	EXPECT_EQ(packet.data, small);
+
+	// A pulled large packet takes the block the previous one gave back
+	tx.push(Packet(large));
+	const auto* storage {rx.pull().data.data()};
+	tx.push(Packet(large));
+	packet = rx.pull();
+	EXPECT_EQ(packet.data.data(), storage);
+	EXPECT_EQ(packet.data, large);
+}
+
+TEST(ring_buffer, crc32c)
+{
+	// Bit at a time reference
+	const auto reference = [](std::span<const uint8_t> data) {
+		uint32_t crc {0xFFFFFFFFu};
+		for (const uint8_t byte : data)
+		{
+			crc ^= byte;
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1u) ^ (0x82F63B78u & (0u - (crc & 1u)));
+			}
+		}
+		return ~crc;
+	};
+
+	const std::string_view check {"123456789"};
+	EXPECT_EQ(Crc32c({reinterpret_cast<const uint8_t*>(check.data()), check.size()}), 0xE3069283u);
+	EXPECT_EQ(Crc32c({}), 0u);
+
+	// Sizes either side of the interleaved block lengths, at odd alignments,
+	// with room for the three byte offset after the largest size
+	std::vector<uint8_t> data(3u + 3u * 8192u * 2u + 100u);
+	for (std::size_t i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<uint8_t>(i * 131u + (i >> 8u));
+	}
+
+	for (const std::size_t size : {1u, 7u, 8u, 63u, 767u, 768u, 769u, 3u * 256u * 5u, 24575u, 24576u, 24577u, 49252u})
+	{
+		const std::span<const uint8_t> input {std::span {data}.subspan(3u, size)};
+		const uint32_t expected {reference(input)};
+
+		EXPECT_EQ(Crc32c(input), expected) << size;
+		EXPECT_EQ(Crc32c(input.subspan(size / 3u), Crc32c(input.first(size / 3u))), expected) << size;
+
+		std::vector<uint8_t> copy(size);
+		EXPECT_EQ(CopyCrc32c(input, copy.data()), expected) << size;
+		EXPECT_TRUE(std::ranges::equal(copy, input)) << size;
+	}
+}
+
+TEST(ring_buffer, checksum)
+{
+	constexpr std::size_t capacity {108u};
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(capacity)};
+	constexpr RingBufferOptions options {.checksum = true};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, options);
+	RxRingBuffer rx(buffer, bufferSize, options);
+
+	// Payloads that wrap, through push and through reserve/commit
+	for (std::size_t i = 0u; i < 64u; ++i)
+	{
+		const std::size_t size {1u + i * 7u % 60u};
+		std::vector<uint8_t> payload(size);
+		std::iota(payload.begin(), payload.end(), static_cast<uint8_t>(i));
+
+		if (i % 2u == 0u)
+		{
+			tx.push(Packet {payload});
+		}
+		else
+		{
+			auto region = tx.reserve(size);
+			const auto split {payload.begin() + static_cast<std::ptrdiff_t>(region.first.size())};
+			std::copy(payload.begin(), split, region.first.begin());
+			std::copy(split, payload.end(), region.second.begin());
+			tx.commit();
+		}
+
+		Packet rxPacket;
+		ASSERT_EQ(rx.tryPull(rxPacket), RingBufferStatus::Ok) << i;
+		EXPECT_EQ(rxPacket.data, payload);
+	}
+
+	EXPECT_EQ(rx.getChecksumMismatchCount(), 0u);
+
+	// Corrupt a payload byte in the ring, the packet is still consumed
+	tx.push(Packet {std::vector<uint8_t>(16u, 0x5Au)});
+	buffer[static_cast<std::size_t>(rx.peek().data.first.data() - buffer)] ^= 0x10u;
+
+	Packet rxPacket;
+	EXPECT_EQ(rx.tryPull(rxPacket), RingBufferStatus::ChecksumMismatch);
+	EXPECT_EQ(rx.getChecksumMismatchCount(), 1u);
+	EXPECT_TRUE(rx.isEmpty());
+
+	tx.push(Packet {std::vector<uint8_t>(16u, 0xA5u)});
+	buffer[static_cast<std::size_t>(rx.peek().data.first.data() - buffer)] ^= 0x01u;
+	EXPECT_THROW(static_cast<void>(rx.pull()), std::runtime_error);
+	EXPECT_EQ(rx.getChecksumMismatchCount(), 2u);
+
+	tx.push(Packet {std::vector<uint8_t>(16u, 0xA5u)});
+	EXPECT_EQ(rx.pull().data, std::vector<uint8_t>(16u, 0xA5u));
+}
+
+TEST(ring_buffer, statistics)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(3u * kPacketHeaderSize + 48u)};
+	constexpr RingBufferOptions options {.statistics = true};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize, options);
+	RxRingBuffer rx(buffer, bufferSize, options);
+
+	Packet packet;
+	EXPECT_EQ(rx.tryPull(packet), RingBufferStatus::Empty);
+	EXPECT_FALSE(rx.pull(std::chrono::milliseconds {1}));
+
+	// 3 packets of 12 bytes fill all but 12 bytes of the buffer
+	tx.push(Packet {std::vector<uint8_t>(10u)});
+	EXPECT_EQ(tx.pushBatch(std::vector<Packet>(3u, Packet {std::vector<uint8_t>(12u)})), 2u);
+	EXPECT_EQ(tx.tryPush(Packet {std::vector<uint8_t>(12u)}), RingBufferStatus::Full);
+
+	EXPECT_EQ(rx.tryPull(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(rx.drain([](const PacketView&) {}), 2u);
+
+	static_cast<void>(tx.reserve(5u));
+	tx.commit();
+	EXPECT_EQ(rx.pull().data.size(), 5u);
+
+	const RingBufferStatistics statistics {tx.getStatistics()};
+	EXPECT_EQ(statistics.capacity, 3u * kPacketHeaderSize + 48u);
+	EXPECT_EQ(statistics.pushedPackets, 4u);
+	EXPECT_EQ(statistics.pushedBytes, 10u + 12u + 12u + 5u);
+	EXPECT_EQ(statistics.fullCount, 2u);
+	EXPECT_EQ(statistics.highWaterMark, 3u * (kPacketHeaderSize + 12u));
+	EXPECT_EQ(statistics.pulledPackets, 4u);
+	EXPECT_EQ(statistics.pulledBytes, statistics.pushedBytes);
+	EXPECT_EQ(statistics.emptyCount, 2u);
+
+	// Both sides see the same counters, and so does anyone reading the memory
+	EXPECT_EQ(rx.getStatistics().pushedBytes, statistics.pushedBytes);
+	EXPECT_EQ(RingBuffer::ReadStatistics(buffer).emptyCount, 2u);
+	EXPECT_THROW(static_cast<void>(RingBuffer::ReadStatistics(std::span<const uint8_t>(buffer).first(64u))), std::invalid_argument);
+
+	// Statistics are opt in per side
+	alignas(kCacheLineSize) uint8_t quietBuffer[bufferSize] {};
+	TxRingBuffer quietTx(quietBuffer, bufferSize);
+	quietTx.push(Packet {std::vector<uint8_t>(10u)});
+	EXPECT_EQ(quietTx.getStatistics().pushedPackets, 0u);
+}
+
+TEST(ring_buffer, latency_histogram)
+{
+	// Buckets tile the range without gaps and stay within 1/16 of their values
+	for (std::size_t bucket = 0u; bucket + 1u < kLatencyBucketCount; ++bucket)
+	{
+		const uint64_t upperBound {GetLatencyBucketUpperBound(bucket)};
+		EXPECT_EQ(GetLatencyBucket(upperBound), bucket);
+		EXPECT_EQ(GetLatencyBucket(upperBound + 1u), bucket + 1u);
+
+		if (bucket > 0u)
+		{
+			const uint64_t lowerBound {GetLatencyBucketUpperBound(bucket - 1u) + 1u};
+			EXPECT_LE((upperBound - lowerBound) * 16u, lowerBound);
+		}
+	}
+
+	EXPECT_EQ(GetLatencyBucket(~uint64_t {0u}), kLatencyBucketCount - 1u);
+
+	auto histogram {std::make_unique<LatencyHistogram>()};
+	EXPECT_EQ(histogram->snapshot().getPercentile(50.0), std::chrono::nanoseconds {0});
+
+	for (uint64_t ticks = 1u; ticks <= 1000u; ++ticks)
+	{
+		histogram->record(ticks);
+	}
+
+	const LatencySnapshot snapshot {histogram->snapshot()};
+	const auto toNanoseconds = [](uint64_t ticks) {
+		return std::chrono::nanoseconds {LatencyTicksToNanoseconds(ticks)};
+	};
+
+	EXPECT_EQ(snapshot.count, 1000u);
+	EXPECT_EQ(snapshot.getPercentile(50.0), toNanoseconds(GetLatencyBucketUpperBound(GetLatencyBucket(500u))));
+	EXPECT_EQ(snapshot.getPercentile(99.0), toNanoseconds(GetLatencyBucketUpperBound(GetLatencyBucket(990u))));
+
+	// The last bucket is capped at the largest latency seen
+	EXPECT_EQ(snapshot.getPercentile(99.9), toNanoseconds(1000u));
+	EXPECT_EQ(snapshot.getPercentile(100.0), toNanoseconds(1000u));
+	EXPECT_EQ(snapshot.getMax(), toNanoseconds(1000u));
+
+	histogram->reset();
+	EXPECT_EQ(histogram->snapshot().count, 0u);
+	EXPECT_EQ(histogram->snapshot().getMax(), std::chrono::nanoseconds {0});
+}
+
+TEST(ring_buffer, latency_tracing)
+{
+	constexpr std::size_t bufferSize {RingBuffer::GetMemoryBlockSize(1024u)};
+
+	alignas(kCacheLineSize) uint8_t buffer[bufferSize] {};
+	TxRingBuffer tx(buffer, bufferSize);
+	RxRingBuffer rx(buffer, bufferSize);
+
+	// Every way of consuming a packet records it
+	for (std::size_t i = 0u; i < 3u; ++i)
+	{
+		tx.push(Packet {std::vector<uint8_t>(8u)});
+	}
+
+	static_cast<void>(rx.pull());
+	static_cast<void>(rx.peek());
+	rx.release();
+	EXPECT_EQ(rx.drain([](const PacketView&) {}), 1u);
+
+	const uint64_t expected {IsLatencyTracingBuild() ? 3u : 0u};
+	EXPECT_EQ(rx.getLatency().count, expected);
+	EXPECT_EQ(tx.getLatency().count, expected);
+	EXPECT_EQ(RingBuffer::ReadLatency(buffer).count, expected);
+	EXPECT_LE(rx.getLatency().getPercentile(50.0), rx.getLatency().getMax());
+
+	rx.resetLatency();
+	EXPECT_EQ(rx.getLatency().count, 0u);
+}
@@ -0,0 +1,106 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libsmipc/ring-buffer/robust-mutex.hpp"
+
+#ifdef __linux__
+#	include <cerrno>
+#	include <exception>
+#	include <format>
+#	include <stdexcept>
+
+RobustMutex::RobustMutex(pthread_mutex_t& mutex, std::atomic<uint64_t>* spinCount) noexcept
+	: m_mutex {mutex}
+	, m_spinCount {spinCount}
+{}
+
+void RobustMutex::Initialise(pthread_mutex_t& mutex)
+{
+	pthread_mutexattr_t attributes;
+
+	if (const int result = pthread_mutexattr_init(&attributes); result != 0)
+	{
+		throw std::runtime_error(std::format("Failed to create mutex attributes. Error: {}", result));
+	}
+
+	int result {pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED)};
+
+	if (result == 0)
+	{
+		result = pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+	}
+
+	if (result == 0)
+	{
+		result = pthread_mutex_init(&mutex, &attributes);
+	}
+
+	pthread_mutexattr_destroy(&attributes);
+
+	if (result != 0)
+	{
+		throw std::runtime_error(std::format("Failed to initialise the robust mutex. Error: {}", result));
+	}
+}
+
+void RobustMutex::lock() noexcept
+{
+	if (tryLock())
+	{
+		return;
+	}
+
+	if (m_spinCount != nullptr)
+	{
+		m_spinCount->store(m_spinCount->load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+	}
+
+	// Locking only fails for a mutex that was never initialised or is beyond recovery
+	if (! acquired(pthread_mutex_lock(&m_mutex)))
+	{
+		std::terminate();
+	}
+}
+
+void RobustMutex::unlock() noexcept
+{
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool RobustMutex::tryLock() noexcept
+{
+	return acquired(pthread_mutex_trylock(&m_mutex));
+}
+
+[[nodiscard]]
+auto RobustMutex::acquired(int result) noexcept -> bool
+{
+	if (result == EOWNERDEAD)
+	{
+		pthread_mutex_consistent(&m_mutex);
+		return true;
+	}
+
+	return result == 0;
+}
+#endif
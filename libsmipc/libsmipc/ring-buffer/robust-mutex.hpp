@@ -0,0 +1,79 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef ROBUST_MUTEX_H_
+#define ROBUST_MUTEX_H_
+
+#ifdef __linux__
+#	include <atomic>
+#	include <cstdint>
+#	include <pthread.h>
+
+/**
+ * A process-shared, robust pthread mutex that may live in shared memory.
+ *
+ * If the holder dies, for example a peer process that crashed in the middle
+ * of a push, the next locker takes the mutex over instead of hanging. Ring
+ * buffers only ever publish with a single store at the end of an operation,
+ * so whatever the dead holder left half done was never visible and the
+ * mutex can simply be marked consistent again.
+ *
+ * Contended locking sleeps in the kernel rather than spinning. If a spin
+ * counter is given, every lock that had to wait is added to it, the counter
+ * must only be written by this side.
+ */
+class RobustMutex
+{
+public:
+	RobustMutex(pthread_mutex_t& mutex, std::atomic<uint64_t>* spinCount = nullptr) noexcept;
+	RobustMutex(const RobustMutex&) = delete;
+	RobustMutex& operator=(const RobustMutex&) = delete;
+
+	/**
+	 * Set up a mutex in fresh shared memory, once, before any side uses it.
+	 *
+	 * @throws std::runtime_error if the mutex could not be initialised.
+	 */
+	static void Initialise(pthread_mutex_t& mutex);
+
+	void lock() noexcept;
+	void unlock() noexcept;
+
+	/**
+	 * @return True if the lock was taken.
+	 */
+	bool tryLock() noexcept;
+
+private:
+	/**
+	 * Finish a lock call, recovering the mutex if its last holder died.
+	 */
+	[[nodiscard]]
+	auto acquired(int result) noexcept -> bool;
+
+	pthread_mutex_t& m_mutex;
+	std::atomic<uint64_t>* m_spinCount;
+};
+#endif
+
+#endif  // ROBUST_MUTEX_H_
@@ -23,120 +23,301 @@
 
 #include <libsmipc/ring-buffer/rx-ring-buffer.hpp>
 
-#include <algorithm>
-#include <iterator>
 #include <mutex>
+#include <stdexcept>
+#include <utility>
 
-RxRingBuffer::RxRingBuffer(uint8_t* memory, std::size_t size)
-	: RingBuffer {memory, size}
+static_assert(AlignedSize(kPacketHeaderSize) == kPacketHeaderSize);
+
+RxRingBuffer::RxRingBuffer(uint8_t* memory, std::size_t size, RingBufferMode mode)
+	: RingBuffer {memory, size, mode}
+{}
+
+RxRingBuffer::RxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options)
+	: RingBuffer {memory, size, options}
 {}
 
 [[nodiscard]]
 auto RxRingBuffer::isEmpty() const noexcept -> bool
 {
-	std::lock_guard lock(m_lock);
-	return header->freeSpace == data.size();
+	auto lock {acquireLock()};
+	return loadCursor(header->front, std::memory_order_relaxed) == loadCursor(header->next, std::memory_order_acquire);
 }
 
 [[nodiscard]]
 auto RxRingBuffer::getMessageCount() const noexcept -> uint32_t
 {
-	std::lock_guard lock(m_lock);
-	return header->messageCount;
+	auto lock {acquireLock()};
+
+	// Both sides publish their cursor before their count, so without a lock the consumer can count a packet the
+	// producer has not counted yet. The pull count is read first, and a pull count running ahead reads as empty.
+	const uint32_t pullCount {header->pullCount.load(std::memory_order_acquire)};
+	const uint32_t pushCount {header->pushCount.load(std::memory_order_acquire)};
+	const auto messageCount {static_cast<int32_t>(pushCount - pullCount)};
+
+	return messageCount > 0 ? static_cast<uint32_t>(messageCount) : 0u;
+}
+
+[[nodiscard]]
+auto RxRingBuffer::getChecksumMismatchCount() const noexcept -> uint32_t
+{
+	return header->checksumMismatchCount.load(std::memory_order_relaxed);
+}
+
+void RxRingBuffer::resetLatency() noexcept
+{
+#ifdef SMIPC_LATENCY_TRACING
+	header->latency.reset();
+#endif
 }
 
 [[nodiscard]]
 auto RxRingBuffer::pull() -> Packet
 {
-	if (isEmpty())
+	auto lock {acquireLock()};
+
+	Packet packet;
+
+	if (! readPacket(getReadCursor(), packet))
 	{
-		throw std::runtime_error("No packets in buffer");
+		throw std::runtime_error("Packet checksum mismatch");
 	}
 
-	constexpr uint32_t headerSize {AlignedSize(sizeof(PacketHeader))};
+	return packet;
+}
 
-	std::lock_guard lock(m_lock);
+[[nodiscard]]
+auto RxRingBuffer::tryPull(Packet& packet) -> RingBufferStatus
+{
+	auto lock {acquireLock()};
+
+	const uint64_t cursor {loadCursor(header->front, std::memory_order_relaxed)};
 
-	uint32_t tmpFront {header->front};
-	uint32_t tmpNext {header->next};
-	uint32_t tmpFreeSpace {header->freeSpace};
-	uint32_t tmpMessageCount {header->messageCount};
+	if (cursor == loadCursor(header->next, std::memory_order_acquire))
+	{
+		countEmpty();
+		return RingBufferStatus::Empty;
+	}
 
-	const uint32_t headerStart {tmpFront};
-	const bool headerWrap {tmpFront + headerSize > data.size()};
-	tmpFront = (tmpFront + headerSize) % data.size();
-	tmpFreeSpace += headerSize;
+	return readPacket(cursor, packet) ? RingBufferStatus::Ok : RingBufferStatus::ChecksumMismatch;
+}
 
-	Packet packet;
+[[nodiscard]]
+auto RxRingBuffer::pull(std::chrono::nanoseconds timeout) -> std::optional<Packet>
+{
+	const Deadline deadline {GetDeadline(timeout)};
+	Waiter waiter {options.waitStrategy};
+	bool waited {false};
 
-	if (headerWrap)
+	while (true)
 	{
-		const uint32_t part1Size = data.size() - headerStart;
-		std::copy_n(std::cbegin(data) + headerStart, part1Size, reinterpret_cast<uint8_t*>(&packet.header));
-		std::copy_n(std::cbegin(data), headerSize - part1Size, reinterpret_cast<uint8_t*>(&packet.header) + part1Size);
+		uint32_t pushCount {};
 
-		if constexpr (IsDebugBuild())
 		{
-			std::fill_n(std::begin(data) + headerStart, part1Size, 0u);
-			std::fill_n(std::begin(data), headerSize - part1Size, 0u);
+			auto lock {acquireLock()};
+
+			// Read before the write cursor, so any push after this changes the count we park on
+			pushCount = header->pushCount.load(std::memory_order_acquire);
+
+			const uint64_t cursor {loadCursor(header->front, std::memory_order_relaxed)};
+
+			if (cursor != loadCursor(header->next, std::memory_order_acquire))
+			{
+				Packet packet;
+
+				if (! readPacket(cursor, packet))
+				{
+					throw std::runtime_error("Packet checksum mismatch");
+				}
+
+				return packet;
+			}
+		}
+
+		if (! std::exchange(waited, true))
+		{
+			countEmpty();
+		}
+
+		// Wait outside the lock, the producer needs it to push
+		if (! park(header->pushCount, pushCount, header->rxParked, deadline, waiter))
+		{
+			return std::nullopt;
 		}
 	}
-	else
+}
+
+[[nodiscard]]
+auto RxRingBuffer::wait(std::chrono::nanoseconds timeout) const -> bool
+{
+	const Deadline deadline {GetDeadline(timeout)};
+	Waiter waiter {options.waitStrategy};
+	bool waited {false};
+
+	while (true)
 	{
-		std::copy_n(std::cbegin(data) + headerStart, headerSize, reinterpret_cast<uint8_t*>(&packet.header));
+		uint32_t pushCount {};
 
-		if constexpr (IsDebugBuild())
 		{
-			std::fill_n(std::begin(data) + headerStart, headerSize, 0u);
+			auto lock {acquireLock()};
+
+			pushCount = header->pushCount.load(std::memory_order_acquire);
+
+			if (loadCursor(header->front, std::memory_order_relaxed) != loadCursor(header->next, std::memory_order_acquire))
+			{
+				return true;
+			}
+		}
+
+		if (! std::exchange(waited, true))
+		{
+			countEmpty();
+		}
+
+		if (! park(header->pushCount, pushCount, header->rxParked, deadline, waiter))
+		{
+			return false;
 		}
 	}
+}
+
+[[nodiscard]]
+auto RxRingBuffer::peek() const -> PacketView
+{
+	auto lock {acquireLock()};
+
+	const uint64_t cursor {getReadCursor()};
+
+	PacketView view {readHeader(cursor)};
+	view.data = getSpan(advance(cursor, kPacketHeaderSize), view.header.size);
+
+	return view;
+}
+
+[[nodiscard]]
+auto RxRingBuffer::copyPayload(std::span<uint8_t> destination) -> bool
+{
+	auto lock {acquireLock()};
+
+	const uint64_t cursor {getReadCursor()};
+	const PacketHeader packetHeader {readHeader(cursor)};
+
+	if (destination.size() < packetHeader.size)
+	{
+		throw std::invalid_argument("Destination is smaller than the payload");
+	}
+
+	return readPayload(cursor, packetHeader, destination.first(packetHeader.size));
+}
 
-	const uint32_t dataSize {packet.header.size};
-	const uint32_t alignedDataSize {AlignedSize(dataSize)};
-	const uint32_t dataStart {tmpFront};
-	const bool dataWrap {tmpFront + dataSize > data.size()};
-	tmpFront = (tmpFront + alignedDataSize) % data.size();
-	tmpFreeSpace += alignedDataSize;
+void RxRingBuffer::release()
+{
+	auto lock {acquireLock()};
 
-	packet.data.reserve(dataSize);
+	const uint64_t cursor {getReadCursor()};
+	const PacketHeader packetHeader {readHeader(cursor)};
 
-	if (dataWrap)
+	recordLatency(packetHeader);
+	retire(cursor, packetHeader.size);
+}
+
+auto RxRingBuffer::acquireLock() const noexcept -> std::unique_lock<RingBufferLock>
+{
+	std::unique_lock lock {m_lock, std::defer_lock};
+
+	if (options.mode == RingBufferMode::Locked)
 	{
-		const uint32_t part1Size = data.size() - dataStart;
-		std::copy_n(std::cbegin(data) + dataStart, part1Size, std::back_inserter(packet.data));
-		std::copy_n(std::cbegin(data), dataSize - part1Size, std::back_inserter(packet.data));
+		lock.lock();
+	}
 
-		if constexpr (IsDebugBuild())
-		{
-			std::fill_n(std::begin(data) + dataStart, part1Size, 0u);
-			std::fill_n(std::begin(data), dataSize - part1Size, 0u);
-		}
+	return lock;
+}
+
+[[nodiscard]]
+auto RxRingBuffer::getReadCursor() const -> uint64_t
+{
+	// The read cursor is ours, the write cursor is published by the producer
+	const uint64_t tmpFront {loadCursor(header->front, std::memory_order_relaxed)};
+	const uint64_t tmpNext {loadCursor(header->next, std::memory_order_acquire)};
+
+	if (tmpFront == tmpNext)
+	{
+		countEmpty();
+		throw std::runtime_error("No packets in buffer");
 	}
-	else
+
+	return tmpFront;
+}
+
+[[nodiscard]]
+auto RxRingBuffer::readHeader(uint64_t cursor) const noexcept -> PacketHeader
+{
+	PacketHeader packetHeader {};
+	copyOut(cursor, {reinterpret_cast<uint8_t*>(&packetHeader), kPacketHeaderSize});
+	return packetHeader;
+}
+
+[[nodiscard]]
+auto RxRingBuffer::readPacket(uint64_t cursor, Packet& packet) -> bool
+{
+	packet.header = readHeader(cursor);
+	packet.data.resize(packet.header.size);
+
+	const bool verified {readPayload(cursor, packet.header, packet.data)};
+	recordLatency(packet.header);
+	retire(cursor, packet.header.size);
+
+	return verified;
+}
+
+[[nodiscard]]
+auto RxRingBuffer::readPayload(uint64_t cursor, const PacketHeader& packetHeader, std::span<uint8_t> destination) noexcept -> bool
+{
+	if (! options.checksum)
 	{
-		std::copy_n(std::cbegin(data) + dataStart, dataSize, std::back_inserter(packet.data));
+		copyOut(advance(cursor, kPacketHeaderSize), destination);
+		return true;
+	}
 
-		if constexpr (IsDebugBuild())
-		{
-			std::fill_n(std::begin(data) + dataStart, dataSize, 0u);
-		}
+	// Verified during the copy, so the payload is only read once
+	if (copyOutChecksum(advance(cursor, kPacketHeaderSize), destination) == packetHeader.checksum)
+	{
+		return true;
 	}
 
+	header->checksumMismatchCount.fetch_add(1u, std::memory_order_relaxed);
+	return false;
+}
+
+void RxRingBuffer::retire(uint64_t cursor, uint32_t dataSize) noexcept
+{
+	const uint32_t packetSize {kPacketHeaderSize + AlignedSize(dataSize)};
+
 	if constexpr (IsDebugBuild())
 	{
-		packet.header.size = 0;
+		clear(cursor, packetSize);
 	}
 
-	if (tmpFreeSpace == data.size())
+	publish(advance(cursor, packetSize), 1u, dataSize);
+}
+
+void RxRingBuffer::publish(uint64_t front, uint32_t packetCount, uint64_t byteCount) noexcept
+{
+	if (options.statistics)
 	{
-		tmpFront = 0u;
-		tmpNext = 0u;
+		AddToCounter(header->pulledPackets, packetCount);
+		AddToCounter(header->pulledBytes, byteCount);
 	}
 
-	header->front = tmpFront;
-	header->freeSpace = tmpFreeSpace;
-	header->next = tmpNext;
-	header->messageCount = --tmpMessageCount;
+	// Publishing the read cursor hands the space back to the producer, a parked one waits on the count
+	storeCursor(header->front, front, std::memory_order_release);
+	storeAndWake(header->pullCount, header->pullCount.load(std::memory_order_relaxed) + packetCount, header->txParked);
+}
 
-	return packet;
+void RxRingBuffer::countEmpty() const noexcept
+{
+	if (options.statistics)
+	{
+		AddToCounter(header->emptyCount, 1u);
+	}
 }
@@ -24,29 +24,243 @@
 #ifndef RX_RING_BUFFER_HPP_
 #define RX_RING_BUFFER_HPP_
 
-#include <libsmipc/ring-buffer/dekkar-lock.hpp>
 #include <libsmipc/ring-buffer/packet.hpp>
 #include <libsmipc/ring-buffer/ring-buffer.hpp>
+#include <libsmipc/ring-buffer/ring-buffer-lock.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+/**
+ * A packet still sitting in the ring buffer.
+ *
+ * The payload is only valid until the packet is released.
+ */
+struct PacketView
+{
+	PacketHeader header {};
+	RingBufferSpan<const uint8_t> data {};
+};
 
 class RxRingBuffer: private RingBuffer
 {
 public:
-	RxRingBuffer(uint8_t* memory, std::size_t size);
+	RxRingBuffer(uint8_t* memory, std::size_t size, RingBufferMode mode = RingBufferMode::Locked);
+	RxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options);
 	~RxRingBuffer() = default;
 
+	using RingBuffer::getCapacity;
+	using RingBuffer::getMemoryBlockSize;
+	using RingBuffer::getMode;
+	using RingBuffer::isMirrored;
+	using RingBuffer::hasWideIndices;
+	using RingBuffer::getStatistics;
+	using RingBuffer::getLatency;
+
 	[[nodiscard]]
 	auto isEmpty() const noexcept -> bool;
 
 	[[nodiscard]]
 	auto getMessageCount() const noexcept -> uint32_t;
 
+	/**
+	 * Get how many pulled packets failed checksum verification, over the life
+	 * of the ring buffer.
+	 */
+	[[nodiscard]]
+	auto getChecksumMismatchCount() const noexcept -> uint32_t;
+
+	/**
+	 * Clear the latency histogram, for example after taking a snapshot with
+	 * getLatency() to start a new measurement interval.
+	 */
+	void resetLatency() noexcept;
+
+	/**
+	 * @throws std::runtime_error if the buffer is empty, or if checksums are
+	 * enabled and the packet does not match its checksum. The packet is
+	 * consumed either way.
+	 */
 	[[nodiscard]]
 	auto pull() -> Packet;
 
+	/**
+	 * Pull a packet without throwing when the buffer is empty.
+	 *
+	 * The payload is copied into `packet`, reusing its storage, so a consumer
+	 * that keeps one Packet around does not allocate once it has grown.
+	 *
+	 * @param packet Receives the packet, left untouched if there is none.
+	 * @return Ok once pulled, Empty if there is nothing to pull,
+	 * ChecksumMismatch if the packet was pulled but failed verification.
+	 */
+	[[nodiscard]]
+	auto tryPull(Packet& packet) -> RingBufferStatus;
+
+	/**
+	 * Pull a packet, waiting until the producer pushes one.
+	 *
+	 * The consumer spins according to its wait strategy, then parks on the
+	 * producer's push count, so an idle channel costs no CPU while waiting.
+	 * Pass std::chrono::nanoseconds::max() to wait without a limit.
+	 *
+	 * @param timeout How long to wait for a packet.
+	 * @return The packet, or nothing if the timeout ran out.
+	 * @throws std::runtime_error if the packet does not match its checksum.
+	 */
+	[[nodiscard]]
+	auto pull(std::chrono::nanoseconds timeout) -> std::optional<Packet>;
+
+	/**
+	 * Wait until there is a packet to read, without reading it.
+	 *
+	 * Waits the same way as the blocking pull, for consumers that go on to
+	 * peek() or drain() the packet in place.
+	 *
+	 * @param timeout How long to wait for a packet.
+	 * @return False if the timeout ran out with the buffer still empty.
+	 */
+	[[nodiscard]]
+	auto wait(std::chrono::nanoseconds timeout) const -> bool;
+
+	/**
+	 * Look at the next packet without copying it out of the ring buffer.
+	 *
+	 * Peeking again before release() returns the same packet. The payload is
+	 * not read, so its checksum is not verified.
+	 *
+	 * @return A view of the next packet's header and payload.
+	 * @throws std::runtime_error if the buffer is empty.
+	 */
+	[[nodiscard]]
+	auto peek() const -> PacketView;
+
+	/**
+	 * Copy the payload of the next packet out without releasing it, verifying
+	 * its checksum on the way if checksums are enabled.
+	 *
+	 * @param destination Where to copy the payload, at least as large as it.
+	 * @return False if the payload does not match its checksum.
+	 * @throws std::runtime_error if the buffer is empty.
+	 * @throws std::invalid_argument if the destination is too small.
+	 */
+	[[nodiscard]]
+	auto copyPayload(std::span<uint8_t> destination) -> bool;
+
+	/**
+	 * Drop the next packet, handing its space back to the producer.
+	 *
+	 * @throws std::runtime_error if the buffer is empty.
+	 */
+	void release();
+
+	/**
+	 * Hand every packet that is already in the buffer to a handler, in place.
+	 *
+	 * The producer position is read once up front and the read cursor is
+	 * published once at the end, so a whole burst costs a single
+	 * synchronisation. Packets pushed while draining are left for the next
+	 * call. If the handler throws, the packets handled so far are released
+	 * and the one that threw stays at the front. Payloads are handed over in
+	 * place, so their checksums are not verified.
+	 *
+	 * @param handler Called with a const PacketView& for each packet.
+	 * @param maxPackets The most packets to handle in this call.
+	 * @return The number of packets handled.
+	 */
+	template <class Handler>
+	auto drain(Handler&& handler, std::size_t maxPackets = std::numeric_limits<std::size_t>::max()) -> std::size_t;
+
 private:
-	mutable DekkarLock m_lock {header->rxWaiting, header->txWaiting, header->turn};
+	[[nodiscard]]
+	auto acquireLock() const noexcept -> std::unique_lock<RingBufferLock>;
+
+	[[nodiscard]]
+	auto getReadCursor() const -> uint64_t;
+
+	[[nodiscard]]
+	auto readHeader(uint64_t cursor) const noexcept -> PacketHeader;
+
+	/**
+	 * Copy a packet out and retire it.
+	 *
+	 * @return False if checksums are enabled and the payload does not match.
+	 */
+	[[nodiscard]]
+	auto readPacket(uint64_t cursor, Packet& packet) -> bool;
+
+	[[nodiscard]]
+	auto readPayload(uint64_t cursor, const PacketHeader& packetHeader, std::span<uint8_t> destination) noexcept -> bool;
+
+	void retire(uint64_t cursor, uint32_t dataSize) noexcept;
+	void publish(uint64_t front, uint32_t packetCount, uint64_t byteCount) noexcept;
+	void countEmpty() const noexcept;
+
+	void recordLatency([[maybe_unused]] const PacketHeader& packetHeader) noexcept
+	{
+#ifdef SMIPC_LATENCY_TRACING
+		// The stamps come from the producer's core, clamp in case they run a little ahead
+		const uint64_t now {ReadLatencyClock()};
+		header->latency.record(now > packetHeader.timestamp ? now - packetHeader.timestamp : 0u);
+#endif
+	}
+
+	mutable RingBufferLock m_lock {*header, false, options};
 };
 
+template <class Handler>
+auto RxRingBuffer::drain(Handler&& handler, std::size_t maxPackets) -> std::size_t
+{
+	auto lock {acquireLock()};
+
+	// The read cursor is ours, the write cursor is snapshotted once
+	uint64_t cursor {loadCursor(header->front, std::memory_order_relaxed)};
+	const uint64_t end {loadCursor(header->next, std::memory_order_acquire)};
+	uint32_t packetCount {0u};
+	uint64_t byteCount {0u};
+
+	try
+	{
+		while (cursor != end && packetCount < maxPackets)
+		{
+			PacketView view {readHeader(cursor)};
+			view.data = getSpan(advance(cursor, kPacketHeaderSize), view.header.size);
+
+			handler(std::as_const(view));
+			recordLatency(view.header);
+
+			const uint32_t packetSize {kPacketHeaderSize + AlignedSize(view.header.size)};
+
+			if constexpr (IsDebugBuild())
+			{
+				clear(cursor, packetSize);
+			}
+
+			cursor = advance(cursor, packetSize);
+			byteCount += view.header.size;
+			++packetCount;
+		}
+	}
+	catch (...)
+	{
+		if (packetCount > 0u)
+		{
+			publish(cursor, packetCount, byteCount);
+		}
+
+		throw;
+	}
+
+	if (packetCount > 0u)
+	{
+		publish(cursor, packetCount, byteCount);
+	}
+
+	return packetCount;
+}
+
 #endif  // RX_RING_BUFFER_HPP_
@@ -0,0 +1,63 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "libsmipc/ring-buffer/ticket-lock.hpp"
+
+TicketLock::TicketLock(std::atomic<uint32_t>& next, std::atomic<uint32_t>& serving, WaitStrategy strategy, std::atomic<uint64_t>* spinCount) noexcept
+	: m_next {next}
+	, m_serving {serving}
+	, m_strategy {strategy}
+	, m_spinCount {spinCount}
+{}
+
+void TicketLock::lock() noexcept
+{
+	const uint32_t ticket {m_next.fetch_add(1u, std::memory_order_relaxed)};
+
+	Waiter waiter {m_strategy};
+	uint64_t spins {0u};
+
+	while (m_serving.load(std::memory_order_acquire) != ticket)
+	{
+		waiter.wait();
+		++spins;
+	}
+
+	if (spins > 0u && m_spinCount != nullptr)
+	{
+		m_spinCount->store(m_spinCount->load(std::memory_order_relaxed) + spins, std::memory_order_relaxed);
+	}
+}
+
+void TicketLock::unlock() noexcept
+{
+	// Only the holder moves `serving` on
+	m_serving.store(m_serving.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+}
+
+bool TicketLock::tryLock() noexcept
+{
+	// Draw a ticket only if it would be served straight away
+	uint32_t ticket {m_serving.load(std::memory_order_acquire)};
+	return m_next.compare_exchange_strong(ticket, ticket + 1u, std::memory_order_acquire, std::memory_order_relaxed);
+}
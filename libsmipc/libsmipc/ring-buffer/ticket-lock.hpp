@@ -0,0 +1,63 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TICKET_LOCK_H_
+#define TICKET_LOCK_H_
+
+#include <libsmipc/ring-buffer/wait-strategy.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * First come, first served spin lock on two counters that may live in shared
+ * memory.
+ *
+ * Each locker draws a ticket from `next` and waits until `serving` reaches it,
+ * so neither side can starve the other however hard it hammers the lock.
+ * Waiting follows the given wait strategy. If a spin counter is given, every
+ * wait is added to it, the counter must only be written by this side.
+ */
+class TicketLock
+{
+public:
+	TicketLock(std::atomic<uint32_t>& next, std::atomic<uint32_t>& serving, WaitStrategy strategy = WaitStrategy::Backoff, std::atomic<uint64_t>* spinCount = nullptr) noexcept;
+	TicketLock(const TicketLock&) = delete;
+	TicketLock& operator=(const TicketLock&) = delete;
+
+	void lock() noexcept;
+	void unlock() noexcept;
+
+	/**
+	 * @return True if the lock was taken.
+	 */
+	bool tryLock() noexcept;
+
+private:
+	std::atomic<uint32_t>& m_next;
+	std::atomic<uint32_t>& m_serving;
+	WaitStrategy m_strategy;
+	std::atomic<uint64_t>* m_spinCount;
+};
+
+#endif  // TICKET_LOCK_H_
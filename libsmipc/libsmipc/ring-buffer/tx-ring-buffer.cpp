@@ -26,84 +26,376 @@
 #include <algorithm>
 #include <mutex>
 #include <stdexcept>
+#include <utility>
 
-TxRingBuffer::TxRingBuffer(uint8_t* memory, std::size_t size)
-	: RingBuffer{memory, size}
+static_assert(AlignedSize(kPacketHeaderSize) == kPacketHeaderSize);
+
+TxRingBuffer::TxRingBuffer(uint8_t* memory, std::size_t size, RingBufferMode mode)
+	: RingBuffer {memory, size, mode}
+{}
+
+TxRingBuffer::TxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options)
+	: RingBuffer {memory, size, options}
 {}
 
 [[nodiscard]]
 auto TxRingBuffer::isFull() const noexcept -> bool
 {
-	std::lock_guard lock(m_lock);
-	return header->freeSpace <= 0u;
+	auto lock {acquireLock()};
+	return getUsedSpace(loadCursor(header->front, std::memory_order_acquire), loadCursor(header->next, std::memory_order_relaxed)) >= getCapacity();
 }
 
 void TxRingBuffer::push(const Packet& packet)
 {
+	if (tryPush(packet) != RingBufferStatus::Ok)
+	{
+		throw std::overflow_error("Buffer overflow");
+	}
+}
+
+[[nodiscard]]
+auto TxRingBuffer::tryPush(const Packet& packet) -> RingBufferStatus
+{
+	throwIfReserved();
+
 	// If the data size is 0, there is nothing to do
 	if (packet.data.size() == 0)
 	{
-		return;
+		return RingBufferStatus::Ok;
+	}
+
+	if (! fitsInCapacity(packet.data.size()))
+	{
+		return RingBufferStatus::TooLarge;
 	}
 
-	const uint32_t headerSize {static_cast<uint32_t>(sizeof(PacketHeader))};
 	const uint32_t dataSize {static_cast<uint32_t>(packet.data.size())};
-	const uint32_t alignedDataSize {AlignedSize(dataSize)};
-	const uint32_t packetSize {headerSize + alignedDataSize};
 
-	std::lock_guard lock(m_lock);
+	auto lock {acquireLock()};
+
+	const uint64_t cursor {loadCursor(header->next, std::memory_order_relaxed)};
+
+	if (kPacketHeaderSize + AlignedSize(dataSize) > getFreeSpace(cursor))
+	{
+		countFull();
+		return RingBufferStatus::Full;
+	}
+
+	publish(writePacket(cursor, packet.header, packet.data), 1u, dataSize);
+
+	return RingBufferStatus::Ok;
+}
+
+[[nodiscard]]
+auto TxRingBuffer::push(const Packet& packet, std::chrono::nanoseconds timeout) -> bool
+{
+	return push(packet.header, packet.data, timeout);
+}
 
-	// Read the buffer header data
-	uint32_t tmpFront {header->front};
-	uint32_t tmpNext {header->next};
-	uint32_t tmpFreeSpace {header->freeSpace};
-	uint32_t tmpMessageCount {header->messageCount};
+[[nodiscard]]
+auto TxRingBuffer::push(const PacketHeader& packetHeader, std::span<const uint8_t> payload, std::chrono::nanoseconds timeout) -> bool
+{
+	throwIfReserved();
 
-	// Check if there is space for the header and the unaligned data, throw if not
-	if (packetSize > tmpFreeSpace)
+	// If the data size is 0, there is nothing to do
+	if (payload.size() == 0)
+	{
+		return true;
+	}
+
+	// Waiting would never help a packet that does not fit in an empty buffer
+	if (! fitsInCapacity(payload.size()))
 	{
 		throw std::overflow_error("Buffer overflow");
 	}
 
-	const uint32_t headerStart {tmpNext};
-	const bool headerWrap {(tmpFront <= tmpNext) && (headerStart + headerSize > data.size())};
-	tmpNext = (tmpNext + headerSize) % data.size();
-	tmpFreeSpace -= headerSize;
+	const uint32_t dataSize {static_cast<uint32_t>(payload.size())};
+	const uint32_t packetSize {kPacketHeaderSize + AlignedSize(dataSize)};
+	const Deadline deadline {GetDeadline(timeout)};
+	Waiter waiter {options.waitStrategy};
+	bool waited {false};
+
+	while (true)
+	{
+		uint32_t pullCount {};
 
-	const uint32_t dataStart {tmpNext};
-	const bool dataWrap {(tmpFront <= tmpNext) && (dataStart + dataSize > data.size())};
-	tmpNext = (tmpNext + alignedDataSize) % data.size();
-	tmpFreeSpace -= alignedDataSize;
+		{
+			auto lock {acquireLock()};
 
-	++tmpMessageCount;
+			// Read before the read cursor, so any pull after this changes the count we park on
+			pullCount = header->pullCount.load(std::memory_order_acquire);
 
-	// Copy back the buffer header data and unlock the buffer
-	// Unlocking the buffer is safe because the message is locked
-	// This means readers can read other messages but not this one
-	header->front = tmpFront;
-	header->next = tmpNext;
-	header->freeSpace = tmpFreeSpace;
-	header->messageCount = tmpMessageCount;
+			const uint64_t cursor {loadCursor(header->next, std::memory_order_relaxed)};
+			const uint64_t front {loadCursor(header->front, std::memory_order_acquire)};
 
-	if (headerWrap)
+			if (packetSize <= getCapacity() - getUsedSpace(front, cursor))
+			{
+				publish(writePacket(cursor, packetHeader, payload), 1u, dataSize);
+				return true;
+			}
+		}
+
+		if (! std::exchange(waited, true))
+		{
+			countFull();
+		}
+
+		// Wait outside the lock, the consumer needs it to free up space
+		if (! park(header->pullCount, pullCount, header->txParked, deadline, waiter))
+		{
+			return false;
+		}
+	}
+}
+
+auto TxRingBuffer::pushBatch(std::span<const Packet> packets) -> std::size_t
+{
+	return pushPackets(packets.size(), [&packets](std::size_t i)
+		{
+			return std::pair<PacketHeader, std::span<const uint8_t>> {packets[i].header, packets[i].data};
+		});
+}
+
+auto TxRingBuffer::pushBatch(std::span<const std::span<const uint8_t>> payloads) -> std::size_t
+{
+	return pushPackets(payloads.size(), [&payloads](std::size_t i)
+		{
+			return std::pair<PacketHeader, std::span<const uint8_t>> {PacketHeader {0u, 0u, 0u, 0u, MakeTransferId()}, payloads[i]};
+		});
+}
+
+[[nodiscard]]
+auto TxRingBuffer::reserve(std::size_t size) -> RingBufferSpan<uint8_t>
+{
+	throwIfReserved();
+
+	if (! fitsInCapacity(size))
 	{
-		const std::size_t part1Size = data.size() - headerStart;
-		std::copy_n(reinterpret_cast<const uint8_t*>(&packet.header), part1Size, std::begin(data) + headerStart);
-		std::copy_n(reinterpret_cast<const uint8_t*>(&packet.header) + part1Size, headerSize - part1Size, std::begin(data));
+		throw std::overflow_error("Buffer overflow");
 	}
-	else
+
+	const uint32_t dataSize {static_cast<uint32_t>(size)};
+
+	auto lock {acquireLock()};
+
+	const uint64_t cursor {claim(dataSize)};
+	m_reservation = Reservation {cursor, dataSize};
+
+	return getSpan(advance(cursor, kPacketHeaderSize), dataSize);
+}
+
+void TxRingBuffer::commit()
+{
+	if (! m_reservation)
 	{
-		std::copy_n(reinterpret_cast<const uint8_t*>(&packet.header), headerSize, std::begin(data) + headerStart);
+		throw std::logic_error("No reservation to commit");
 	}
 
-	if (dataWrap)
+	commit(m_reservation->size);
+}
+
+void TxRingBuffer::commit(std::size_t size)
+{
+	if (! m_reservation)
+	{
+		throw std::logic_error("No reservation to commit");
+	}
+
+	if (size > m_reservation->size)
+	{
+		throw std::invalid_argument("Cannot commit more than was reserved");
+	}
+
+	const uint64_t cursor {m_reservation->cursor};
+	m_reservation.reset();
+
+	// An empty packet is never published, same as push
+	if (size == 0u)
 	{
-		const std::size_t part1Size = data.size() - dataStart;
-		std::copy_n(std::begin(packet.data), part1Size, std::begin(data) + dataStart);
-		std::copy_n(std::begin(packet.data) + part1Size, dataSize - part1Size, std::begin(data));
+		return;
+	}
+
+	const uint32_t dataSize {static_cast<uint32_t>(size)};
+
+	PacketHeader packetHeader {0u, dataSize, 0u, 0u, MakeTransferId()};
+
+	// The payload was written in place, so it has to be read back once to checksum it
+	if (options.checksum)
+	{
+		packetHeader.checksum = getChecksum(advance(cursor, kPacketHeaderSize), dataSize);
+	}
+
+	auto lock {acquireLock()};
+	publish(writePacketHeader(cursor, packetHeader, dataSize), 1u, dataSize);
+}
+
+void TxRingBuffer::cancel() noexcept
+{
+	m_reservation.reset();
+}
+
+auto TxRingBuffer::acquireLock() const noexcept -> std::unique_lock<RingBufferLock>
+{
+	std::unique_lock lock {m_lock, std::defer_lock};
+
+	if (options.mode == RingBufferMode::Locked)
+	{
+		lock.lock();
+	}
+
+	return lock;
+}
+
+void TxRingBuffer::throwIfReserved() const
+{
+	// The reserved space is claimed but not yet published, anything pushed now would be written over it
+	if (m_reservation)
+	{
+		throw std::logic_error("A reservation is pending");
+	}
+}
+
+auto TxRingBuffer::pushPackets(std::size_t count, auto getPacket) -> std::size_t
+{
+	throwIfReserved();
+
+	auto lock {acquireLock()};
+
+	// Free space is only read once, the batch is published in one go
+	const uint64_t start {loadCursor(header->next, std::memory_order_relaxed)};
+	uint64_t freeSpace {getFreeSpace(start)};
+	uint64_t cursor {start};
+	uint32_t packetCount {0u};
+	uint64_t byteCount {0u};
+	std::size_t i {0u};
+
+	for (; i < count; ++i)
+	{
+		const auto [packetHeader, payload] = getPacket(i);
+
+		// If the data size is 0, there is nothing to do
+		if (payload.size() == 0u)
+		{
+			continue;
+		}
+
+		// A packet that can never fit is reported once it reaches the front, retrying it would never get past it
+		if (! fitsInCapacity(payload.size()))
+		{
+			if (packetCount == 0u)
+			{
+				throw std::overflow_error("Buffer overflow");
+			}
+
+			break;
+		}
+
+		const uint32_t dataSize {static_cast<uint32_t>(payload.size())};
+		const uint32_t packetSize {kPacketHeaderSize + AlignedSize(dataSize)};
+
+		if (packetSize > freeSpace)
+		{
+			countFull();
+			break;
+		}
+
+		cursor = writePacket(cursor, packetHeader, payload);
+		freeSpace -= packetSize;
+		byteCount += dataSize;
+		++packetCount;
+	}
+
+	if (packetCount > 0u)
+	{
+		publish(cursor, packetCount, byteCount);
+	}
+
+	return i;
+}
+
+[[nodiscard]]
+auto TxRingBuffer::getFreeSpace(uint64_t next) const noexcept -> uint64_t
+{
+	// The write cursor is ours, the read cursor is published by the consumer
+	return getCapacity() - getUsedSpace(loadCursor(header->front, std::memory_order_acquire), next);
+}
+
+[[nodiscard]]
+auto TxRingBuffer::fitsInCapacity(std::size_t dataSize) const noexcept -> bool
+{
+	return dataSize <= kMaxPacketSize && kPacketHeaderSize + AlignedSize(static_cast<uint32_t>(dataSize)) <= getCapacity();
+}
+
+[[nodiscard]]
+auto TxRingBuffer::claim(uint32_t dataSize) const -> uint64_t
+{
+	const uint32_t packetSize {kPacketHeaderSize + AlignedSize(dataSize)};
+	const uint64_t tmpNext {loadCursor(header->next, std::memory_order_relaxed)};
+
+	// Check if there is space for the header and the aligned data, throw if not
+	if (packetSize > getFreeSpace(tmpNext))
+	{
+		countFull();
+		throw std::overflow_error("Buffer overflow");
+	}
+
+	return tmpNext;
+}
+
+auto TxRingBuffer::writePacketHeader(uint64_t cursor, const PacketHeader& packetHeader, uint32_t dataSize) noexcept -> uint64_t
+{
+	PacketHeader tmpHeader {packetHeader};
+	tmpHeader.size = dataSize;
+#ifdef SMIPC_LATENCY_TRACING
+	tmpHeader.timestamp = ReadLatencyClock();
+#endif
+	copyIn(cursor, {reinterpret_cast<const uint8_t*>(&tmpHeader), kPacketHeaderSize});
+
+	return advance(cursor, kPacketHeaderSize + AlignedSize(dataSize));
+}
+
+auto TxRingBuffer::writePacket(uint64_t cursor, const PacketHeader& packetHeader, std::span<const uint8_t> payload) noexcept -> uint64_t
+{
+	PacketHeader tmpHeader {packetHeader};
+
+	// The checksum is taken during the copy, so the payload is only read once
+	if (options.checksum)
+	{
+		tmpHeader.checksum = copyInChecksum(advance(cursor, kPacketHeaderSize), payload);
 	}
 	else
 	{
-		std::copy(std::begin(packet.data), std::end(packet.data), std::begin(data) + dataStart);
+		copyIn(advance(cursor, kPacketHeaderSize), payload);
+	}
+
+	return writePacketHeader(cursor, tmpHeader, static_cast<uint32_t>(payload.size()));
+}
+
+void TxRingBuffer::publish(uint64_t next, uint32_t packetCount, uint64_t byteCount) noexcept
+{
+	if (options.statistics)
+	{
+		AddToCounter(header->pushedPackets, packetCount);
+		AddToCounter(header->pushedBytes, byteCount);
+
+		// Taken before the consumer can see the new packets, so no pull shrinks it
+		const uint64_t usedSpace {getUsedSpace(loadCursor(header->front, std::memory_order_relaxed), next)};
+
+		if (usedSpace > header->highWaterMark.load(std::memory_order_relaxed))
+		{
+			header->highWaterMark.store(usedSpace, std::memory_order_relaxed);
+		}
 	}
-}
\ No newline at end of file
+
+	// Publishing the write cursor hands the packets over to the consumer, a parked one waits on the count
+	storeCursor(header->next, next, std::memory_order_release);
+	storeAndWake(header->pushCount, header->pushCount.load(std::memory_order_relaxed) + packetCount, header->rxParked);
+}
+
+void TxRingBuffer::countFull() const noexcept
+{
+	if (options.statistics)
+	{
+		AddToCounter(header->fullCount, 1u);
+	}
+}
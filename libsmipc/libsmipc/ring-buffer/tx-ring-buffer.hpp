@@ -24,25 +24,163 @@
 #ifndef TX_RING_BUFFER_H_
 #define TX_RING_BUFFER_H_
 
-#include <libsmipc/ring-buffer/dekkar-lock.hpp>
 #include <libsmipc/ring-buffer/packet.hpp>
 #include <libsmipc/ring-buffer/ring-buffer.hpp>
+#include <libsmipc/ring-buffer/ring-buffer-lock.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
 
 class TxRingBuffer: public RingBuffer
 {
 public:
-	TxRingBuffer(uint8_t* memory, std::size_t size);
+	TxRingBuffer(uint8_t* memory, std::size_t size, RingBufferMode mode = RingBufferMode::Locked);
+	TxRingBuffer(uint8_t* memory, std::size_t size, const RingBufferOptions& options);
 	~TxRingBuffer() = default;
 
 	[[nodiscard]]
 	auto isFull() const noexcept -> bool;
 
+	/**
+	 * @throws std::overflow_error if there is not enough free space.
+	 * @throws std::logic_error if a reservation is pending.
+	 */
 	void push(const Packet& packet);
 
+	/**
+	 * Push a packet without throwing on backpressure, for producers that
+	 * expect it.
+	 *
+	 * @param packet The packet to push, empty packets are skipped.
+	 * @return Ok once pushed, Full if there is not enough free space right
+	 * now, TooLarge if the packet can never fit.
+	 * @throws std::logic_error if a reservation is pending.
+	 */
+	[[nodiscard]]
+	auto tryPush(const Packet& packet) -> RingBufferStatus;
+
+	/**
+	 * Push a packet, waiting until the consumer frees enough space.
+	 *
+	 * The producer spins according to its wait strategy, then parks on the
+	 * consumer's pull count, so a full buffer costs no CPU while waiting.
+	 * Pass std::chrono::nanoseconds::max() to wait without a limit.
+	 *
+	 * @param packet The packet to push.
+	 * @param timeout How long to wait for space.
+	 * @return False if the timeout ran out before the packet fit.
+	 * @throws std::overflow_error if the packet can never fit in the buffer.
+	 * @throws std::logic_error if a reservation is pending.
+	 */
+	[[nodiscard]]
+	auto push(const Packet& packet, std::chrono::nanoseconds timeout) -> bool;
+
+	/**
+	 * Blocking push of a payload under a given header, without building a
+	 * Packet first. The header's size field is filled in from the payload.
+	 *
+	 * @see push(const Packet&, std::chrono::nanoseconds)
+	 */
+	[[nodiscard]]
+	auto push(const PacketHeader& packetHeader, std::span<const uint8_t> payload, std::chrono::nanoseconds timeout) -> bool;
+
+	/**
+	 * Push as many packets as fit, publishing them all at once.
+	 *
+	 * The free space is read once and the write cursor and message count are
+	 * updated once for the whole batch. Empty packets are skipped, as with
+	 * push. Pushing stops at the first packet that does not fit in the free
+	 * space, so the rest of the batch can be retried once the consumer has
+	 * caught up. A packet too large for the ring's capacity ends the batch
+	 * the same way, then throws when a retry starts with it.
+	 *
+	 * @param packets The packets to push, in order.
+	 * @return The number of packets consumed from the front of the batch.
+	 * @throws std::overflow_error if the first packet to push is larger than
+	 * the ring buffer can ever hold, nothing is pushed.
+	 * @throws std::logic_error if a reservation is pending.
+	 */
+	auto pushBatch(std::span<const Packet> packets) -> std::size_t;
+
+	/**
+	 * Gather variant of pushBatch, each payload becomes its own packet.
+	 *
+	 * @param payloads The packet payloads to push, in order.
+	 * @return The number of payloads consumed from the front of the batch.
+	 * @throws std::overflow_error if the first payload to push is larger than
+	 * the ring buffer can ever hold, nothing is pushed.
+	 * @throws std::logic_error if a reservation is pending.
+	 */
+	auto pushBatch(std::span<const std::span<const uint8_t>> payloads) -> std::size_t;
+
+	/**
+	 * Reserve space for a packet directly in the ring buffer.
+	 *
+	 * The returned region can be written in place, for example with
+	 * Serialisable::serialiseInto, and is handed to the consumer by commit().
+	 * If the region wraps around the end of the buffer it is split in two.
+	 * Nothing else can be pushed until the reservation is committed or
+	 * cancelled.
+	 *
+	 * @param size The number of payload bytes to reserve.
+	 * @return The writable payload region.
+	 * @throws std::overflow_error if there is not enough free space.
+	 * @throws std::logic_error if a reservation is already pending.
+	 */
+	[[nodiscard]]
+	auto reserve(std::size_t size) -> RingBufferSpan<uint8_t>;
+
+	/**
+	 * Publish the pending reservation as a packet.
+	 */
+	void commit();
+
+	/**
+	 * Publish the first size bytes of the pending reservation as a packet.
+	 *
+	 * @param size The number of payload bytes actually written.
+	 * @throws std::invalid_argument if size is larger than the reservation.
+	 */
+	void commit(std::size_t size);
+
+	/**
+	 * Drop the pending reservation without publishing anything.
+	 */
+	void cancel() noexcept;
+
 private:
-	mutable DekkarLock m_lock {header->txWaiting, header->rxWaiting, header->turn};
+	struct Reservation
+	{
+		uint64_t cursor {};
+		uint32_t size {};
+	};
+
+	[[nodiscard]]
+	auto acquireLock() const noexcept -> std::unique_lock<RingBufferLock>;
+
+	void throwIfReserved() const;
+
+	auto pushPackets(std::size_t count, auto getPacket) -> std::size_t;
+
+	[[nodiscard]]
+	auto getFreeSpace(uint64_t next) const noexcept -> uint64_t;
+
+	[[nodiscard]]
+	auto fitsInCapacity(std::size_t dataSize) const noexcept -> bool;
+
+	[[nodiscard]]
+	auto claim(uint32_t dataSize) const -> uint64_t;
+
+	auto writePacketHeader(uint64_t cursor, const PacketHeader& packetHeader, uint32_t dataSize) noexcept -> uint64_t;
+	auto writePacket(uint64_t cursor, const PacketHeader& packetHeader, std::span<const uint8_t> payload) noexcept -> uint64_t;
+	void publish(uint64_t next, uint32_t packetCount, uint64_t byteCount) noexcept;
+	void countFull() const noexcept;
+
+	mutable RingBufferLock m_lock {*header, true, options};
+	std::optional<Reservation> m_reservation {};
 };
 
 #endif  // TX_RING_BUFFER_H_
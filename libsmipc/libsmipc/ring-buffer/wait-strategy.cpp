@@ -0,0 +1,131 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/ring-buffer/wait-strategy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	include <immintrin.h>
+#endif
+
+// Backoff doubles the pauses up to 2^10 per wait
+static constexpr uint32_t kMaxBackoffShift {10u};
+
+// SpinYield and Adaptive stage lengths, in calls to wait()
+static constexpr uint32_t kSpinCount {16u};
+static constexpr uint32_t kPauseCount {64u};
+static constexpr uint32_t kYieldCount {32u};
+
+static constexpr std::chrono::microseconds kSleepTime {50};
+
+void CpuRelax() noexcept
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	asm volatile("yield");
+#endif
+}
+
+Waiter::Waiter(WaitStrategy strategy) noexcept
+	: m_strategy {strategy}
+{}
+
+void Waiter::wait() noexcept
+{
+	switch (m_strategy)
+	{
+	case WaitStrategy::BusySpin:
+		break;
+
+	case WaitStrategy::Backoff:
+		for (uint32_t i = 0u; i < (1u << std::min(m_count, kMaxBackoffShift)); ++i)
+		{
+			CpuRelax();
+		}
+		break;
+
+	case WaitStrategy::SpinYield:
+		if (m_count < kPauseCount)
+		{
+			CpuRelax();
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+		break;
+
+	case WaitStrategy::Adaptive:
+		if (m_count < kSpinCount)
+		{
+			// Plain re-check, the peer is most likely about to finish
+		}
+		else if (m_count < kSpinCount + kPauseCount)
+		{
+			CpuRelax();
+		}
+		else if (m_count < kSpinCount + kPauseCount + kYieldCount)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for(kSleepTime);
+		}
+		break;
+	}
+
+	// Saturate rather than wrap back to the cheap stages
+	m_count += m_count != std::numeric_limits<uint32_t>::max() ? 1u : 0u;
+}
+
+[[nodiscard]]
+auto Waiter::isExhausted() const noexcept -> bool
+{
+	switch (m_strategy)
+	{
+	case WaitStrategy::BusySpin:
+		return false;
+
+	case WaitStrategy::Backoff:
+		return m_count > kMaxBackoffShift;
+
+	case WaitStrategy::SpinYield:
+		return m_count >= kPauseCount + kYieldCount;
+
+	case WaitStrategy::Adaptive:
+		return m_count >= kSpinCount + kPauseCount + kYieldCount;
+	}
+
+	return true;
+}
+
+void Waiter::reset() noexcept
+{
+	m_count = 0u;
+}
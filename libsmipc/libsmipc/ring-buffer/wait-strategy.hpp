@@ -0,0 +1,82 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WAIT_STRATEGY_H_
+#define WAIT_STRATEGY_H_
+
+#include <cstdint>
+
+/**
+ * How a thread waits on a peer, used by the ring buffer locks and by the
+ * blocking push and pull.
+ *
+ * BusySpin re-checks as fast as it can and gives the lowest latency at the
+ * cost of a whole core. Backoff issues a CPU pause hint and doubles the
+ * number of pauses on every attempt. SpinYield pauses for a while, then
+ * yields the rest of the time slice. Adaptive goes through spinning, pausing
+ * and yielding before it sleeps.
+ *
+ * Blocking operations park on a futex once a strategy is exhausted, BusySpin
+ * never parks.
+ */
+enum class WaitStrategy : uint32_t
+{
+	BusySpin,
+	Backoff,
+	SpinYield,
+	Adaptive,
+};
+
+/**
+ * Tell the CPU we are in a spin loop, `pause` on x86 and `yield` on ARM.
+ */
+void CpuRelax() noexcept;
+
+/**
+ * The state of a single wait, one instance per wait loop.
+ */
+class Waiter
+{
+public:
+	explicit Waiter(WaitStrategy strategy) noexcept;
+
+	/**
+	 * Wait once, each call waits as long as or longer than the one before.
+	 */
+	void wait() noexcept;
+
+	/**
+	 * Whether the strategy has run out of spinning and a caller that is able
+	 * to block should do so now.
+	 */
+	[[nodiscard]]
+	auto isExhausted() const noexcept -> bool;
+
+	void reset() noexcept;
+
+private:
+	WaitStrategy m_strategy;
+	uint32_t m_count {0u};
+};
+
+#endif  // WAIT_STRATEGY_H_
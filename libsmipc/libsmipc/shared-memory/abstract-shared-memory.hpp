@@ -26,24 +26,139 @@
 
 #include <libsmipc/shared-memory/shared-memory-view.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
+/**
+ * Where the pages of a shared memory segment are placed on a machine with
+ * several NUMA nodes.
+ */
+enum class NumaPolicy : uint32_t
+{
+	// Each page lands on the node of whichever process touches it first
+	FirstTouch,
+	// Every page lands on SharedMemoryOptions::numaNode
+	Bind,
+	// Pages are spread round robin over all nodes the process may use
+	Interleave,
+};
+
+/**
+ * Which implementation of ISharedMemory MakeUniqueSharedMemory() hands out.
+ */
+enum class SharedMemoryBackend : uint32_t
+{
+	// A segment the peer finds by name, in /dev/shm or on a hugetlbfs mount on Linux
+	Named,
+	// An anonymous memory file whose descriptor the creator hands to the peer, see MemfdSharedMemory
+	Memfd,
+};
+
+/**
+ * Options used when creating a shared memory segment.
+ *
+ * A mirrored segment maps its data region twice, back to back, so a ring buffer
+ * placed in it never has to split a read or write at the end of the buffer.
+ * The first `mirrorOffset` bytes of the data region, typically the ring buffer
+ * header, sit in front of the mirrored part and are not repeated. They may
+ * span several pages, the mirrored part starts on the page boundary after
+ * them. Mirroring rounds the segment up to whole pages and is only supported
+ * on Linux.
+ *
+ * Setting `hugePageSize`, typically to kHugePageSize2M or kHugePageSize1G,
+ * backs the segment with huge pages of that size from a hugetlbfs mount,
+ * rounding it up to whole huge pages, which saves TLB misses on large rings.
+ * Without a mount for that size or enough free pages in its pool the segment
+ * gets normal pages and asks for transparent huge pages instead, which is only
+ * a hint. getPageSize() reports what the segment ended up with. Huge pages are
+ * only supported on Linux, other platforms ignore the option.
+ *
+ * Pages fault in lazily, on first touch, so the first pass around a fresh ring
+ * pays for them one at a time. Setting `prefault` faults the whole mapping in
+ * up front, `lock` additionally keeps it resident so it is never paged out.
+ * getWarmUpTime() reports how long that took. The peer opening the segment has
+ * its own page tables and decides for itself, see SharedMemoryOpenOptions.
+ *
+ * On machines with several NUMA nodes `numaPolicy` decides where the pages of
+ * the segment land, see NumaPolicy. Leaving it at first touch and opening the
+ * segment with `prefault` on the consumer's side places the pages next to the
+ * consumer. Placement is best effort: on a single node machine, or for a node
+ * that does not exist, the pages are placed as if on first touch.
+ * getNumaNode() reports where they ended up. NUMA placement is only supported
+ * on Linux, Windows only honours binding to a node.
+ *
+ * The backend is only looked at by the pipe factories, which pass it on to
+ * MakeUniqueSharedMemory(). Both sides of a pipe must use the same one.
+ */
+struct SharedMemoryOptions
+{
+	bool mirrored {false};
+	std::size_t mirrorOffset {0u};
+	std::size_t hugePageSize {0u};
+	bool prefault {false};
+	bool lock {false};
+	NumaPolicy numaPolicy {NumaPolicy::FirstTouch};
+	uint32_t numaNode {0u};
+	SharedMemoryBackend backend {SharedMemoryBackend::Named};
+};
+
+/**
+ * Options used when opening a shared memory segment. The layout is taken from
+ * the segment, only the warm-up of this side's mapping is up to the opener.
+ *
+ * A `readOnly` view is for observers such as a statistics monitor. It maps the
+ * segment read-only, does not count as a reference and leaves the segment's
+ * name in place when closed, so the peers using it never notice. Nothing may
+ * be written through it, a ring buffer cannot be attached to it.
+ *
+ * @see SharedMemoryOptions
+ */
+struct SharedMemoryOpenOptions
+{
+	bool prefault {false};
+	bool lock {false};
+	SharedMemoryBackend backend {SharedMemoryBackend::Named};
+	bool readOnly {false};
+};
+
+constexpr std::size_t kHugePageSize2M {2u * 1024u * 1024u};
+constexpr std::size_t kHugePageSize1G {1024u * 1024u * 1024u};
+
 class ISharedMemory
 {
 public:
 	virtual ~ISharedMemory() = default;
 
-	virtual void create(const std::string& name, std::size_t size) = 0;
-	virtual void open(const std::string& name) = 0;
+	virtual void create(const std::string& name, std::size_t size, const SharedMemoryOptions& options = {}) = 0;
+	virtual void open(const std::string& name, const SharedMemoryOpenOptions& options = {}) = 0;
 	virtual void close() = 0;
 	virtual void closeAll() = 0;
 
 	virtual auto getName() const -> std::string_view = 0;
 	virtual auto getSize() const -> std::size_t = 0;
+	virtual auto isMirrored() const -> bool = 0;
+
+	/**
+	 * Get the size of the pages backing the segment, larger than the system
+	 * page size when it got huge pages.
+	 */
+	virtual auto getPageSize() const -> std::size_t = 0;
+
+	/**
+	 * Get how long faulting in and locking the mapping took when it was
+	 * created or opened, zero if neither was asked for.
+	 */
+	virtual auto getWarmUpTime() const -> std::chrono::nanoseconds = 0;
+
+	/**
+	 * Get the NUMA node holding most of the segment's pages that are in
+	 * memory, or -1 if none are yet or the platform cannot tell.
+	 */
+	virtual auto getNumaNode() const -> int = 0;
 	virtual auto getView() -> SharedMemoryView = 0;
 	virtual auto getView() const -> const SharedMemoryView = 0;
 };
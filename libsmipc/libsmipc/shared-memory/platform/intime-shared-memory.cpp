@@ -27,7 +27,7 @@
 #include <stdexcept>
 #include <windows.h>
 
-void IntimeSharedMemory::create(const std::string& name, std::size_t size)
+void IntimeSharedMemory::create(const std::string& name, std::size_t size, const SharedMemoryOptions& options)
 {
 	// if (m_handle != 0)
 	// {
@@ -66,14 +66,14 @@ void IntimeSharedMemory::create(const std::string& name, std::size_t size)
 	// *m_view.signals = 0u;
 	// m_view.refCount = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewRefCountOffset);
 	// *m_view.refCount = 1u;
-	// m_view.dataSize = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
+	// m_view.dataSize = reinterpret_cast<uint64_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
 	// *m_view.dataSize = m_size - kSharedMemoryViewDataOffset;
 	// m_view.data = m_buffer + kSharedMemoryViewDataOffset;
 
 	// m_view.lock->clear(std::memory_order_release);
 }
 
-void IntimeSharedMemory::open(const std::string& name)
+void IntimeSharedMemory::open(const std::string& name, const SharedMemoryOpenOptions& options)
 {
 	// if (m_handle != 0)
 	// {
@@ -106,7 +106,7 @@ void IntimeSharedMemory::open(const std::string& name)
 	// m_view.signals = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewSignalsOffset);
 	// m_view.refCount = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewRefCountOffset);
 	// (*m_view.refCount)++;
-	// m_view.dataSize = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
+	// m_view.dataSize = reinterpret_cast<uint64_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
 	// m_size = *m_view.dataSize + kSharedMemoryViewDataOffset;
 	// m_view.data = m_buffer + kSharedMemoryViewDataOffset;
 
@@ -167,6 +167,26 @@ auto IntimeSharedMemory::getSize() const -> std::size_t
 	return m_size;
 }
 
+auto IntimeSharedMemory::isMirrored() const -> bool
+{
+	return false;
+}
+
+auto IntimeSharedMemory::getPageSize() const -> std::size_t
+{
+	return 4096u;
+}
+
+auto IntimeSharedMemory::getWarmUpTime() const -> std::chrono::nanoseconds
+{
+	return std::chrono::nanoseconds::zero();
+}
+
+auto IntimeSharedMemory::getNumaNode() const -> int
+{
+	return -1;
+}
+
 auto IntimeSharedMemory::getView() -> SharedMemoryView
 {
 	return m_view;
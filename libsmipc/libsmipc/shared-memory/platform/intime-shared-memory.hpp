@@ -27,6 +27,7 @@
 #include <libsmipc/shared-memory/abstract-shared-memory.hpp>
 #include <libsmipc/shared-memory/shared-memory-view.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -34,12 +35,16 @@
 class IntimeSharedMemory: public ISharedMemory
 {
 public:
-	void create(const std::string& name, std::size_t size) final;
-	void open(const std::string& name) final;
+	void create(const std::string& name, std::size_t size, const SharedMemoryOptions& options = {}) final;
+	void open(const std::string& name, const SharedMemoryOpenOptions& options = {}) final;
 	void close() final;
 	void closeAll() final;
 	auto getName() const -> std::string_view final;
 	auto getSize() const -> std::size_t final;
+	auto isMirrored() const -> bool final;
+	auto getPageSize() const -> std::size_t final;
+	auto getWarmUpTime() const -> std::chrono::nanoseconds final;
+	auto getNumaNode() const -> int final;
 	auto getView() -> SharedMemoryView final;
 	auto getView() const -> const SharedMemoryView final;
 
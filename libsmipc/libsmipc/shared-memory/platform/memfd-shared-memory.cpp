@@ -0,0 +1,339 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/shared-memory/platform/memfd-shared-memory.hpp>
+
+#include <fcntl.h>
+#include <linux/memfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+/**
+ * Make the address of a segment's socket, in the abstract namespace so it
+ * disappears with the socket.
+ *
+ * @throws std::invalid_argument if the name does not fit in a socket address.
+ */
+[[nodiscard]]
+static auto MakeSocketAddress(const std::string& name, socklen_t& length) -> sockaddr_un
+{
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+
+	if (name.empty() || name.size() >= sizeof(address.sun_path))
+	{
+		throw std::invalid_argument("Shared memory name does not fit in a socket address.");
+	}
+
+	// The leading null byte puts the socket in the abstract namespace
+	std::memcpy(address.sun_path + 1, name.data(), name.size());
+	length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1u + name.size());
+
+	return address;
+}
+
+/**
+ * Send a descriptor over a connected socket, along with a single byte as
+ * ancillary data cannot travel on its own.
+ */
+static void SendDescriptor(int connection, int descriptor)
+{
+	char byte {};
+	iovec data {.iov_base = &byte, .iov_len = sizeof(byte)};
+
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] {};
+	msghdr message {};
+	message.msg_iov = &data;
+	message.msg_iovlen = 1u;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	cmsghdr* header {CMSG_FIRSTHDR(&message)};
+	header->cmsg_level = SOL_SOCKET;
+	header->cmsg_type = SCM_RIGHTS;
+	header->cmsg_len = CMSG_LEN(sizeof(int));
+	std::memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+
+	// A peer that hung up has to ask again, there is nobody to report it to
+	static_cast<void>(sendmsg(connection, &message, MSG_NOSIGNAL));
+}
+
+/**
+ * Ask the creator of a segment for its descriptor.
+ *
+ * @throws std::runtime_error if there is no such segment or no descriptor
+ * came back.
+ */
+[[nodiscard]]
+static auto ReceiveDescriptor(const std::string& name) -> int
+{
+	socklen_t length {};
+	const sockaddr_un address {MakeSocketAddress(name, length)};
+	const int connection {socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)};
+
+	if (connection == -1)
+	{
+		throw std::runtime_error(std::format("Failed to create socket. Errno: {}", errno));
+	}
+
+	if (connect(connection, reinterpret_cast<const sockaddr*>(&address), length) == -1)
+	{
+		const int error {errno};
+		::close(connection);
+		throw std::runtime_error(std::format("Failed to connect to shared memory creator. Errno: {}", error));
+	}
+
+	char byte {};
+	iovec data {.iov_base = &byte, .iov_len = sizeof(byte)};
+
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] {};
+	msghdr message {};
+	message.msg_iov = &data;
+	message.msg_iovlen = 1u;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received {};
+
+	do
+	{
+		received = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+	}
+	while (received == -1 && errno == EINTR);
+
+	const int error {errno};
+	::close(connection);
+
+	const cmsghdr* header {received > 0 ? CMSG_FIRSTHDR(&message) : nullptr};
+
+	if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(sizeof(int)))
+	{
+		throw std::runtime_error(std::format("Failed to receive shared memory descriptor. Errno: {}", received == -1 ? error : 0));
+	}
+
+	int descriptor {};
+	std::memcpy(&descriptor, CMSG_DATA(header), sizeof(int));
+
+	return descriptor;
+}
+
+MemfdSharedMemory::~MemfdSharedMemory()
+{
+	stopServing();
+}
+
+void MemfdSharedMemory::create(const std::string& name, std::size_t size, const SharedMemoryOptions& options)
+{
+	if (m_handle != 0)
+	{
+		throw std::runtime_error("Shared memory already created.");
+	}
+
+	m_name = name;
+	m_readOnly = false;
+
+	SegmentLayout layout {};
+	void* buffer {MAP_FAILED};
+
+	// Huge pages are best effort, without enough free pages in the pool the segment gets normal ones
+	if (options.hugePageSize != 0u && options.hugePageSize != GetPageSize() && std::has_single_bit(options.hugePageSize))
+	{
+		layout = GetLayout(size, options, options.hugePageSize, true);
+		buffer = createFile(layout, MFD_HUGETLB | (static_cast<unsigned int>(std::countr_zero(options.hugePageSize)) << MFD_HUGE_SHIFT));
+	}
+
+	if (buffer == MAP_FAILED)
+	{
+		layout = GetLayout(size, options, GetPageSize(), false);
+		buffer = createFile(layout, 0u);
+
+		if (buffer == MAP_FAILED)
+		{
+			throw std::runtime_error(std::format("Failed to create memory file. Errno: {}", errno));
+		}
+
+		// Only a hint, see PosixSharedMemory
+		if (options.hugePageSize != 0u)
+		{
+			madvise(buffer, m_mappedSize, MADV_HUGEPAGE);
+		}
+	}
+
+	initialiseView(buffer, layout, options);
+
+	try
+	{
+		listen();
+	}
+	catch (...)
+	{
+		close();
+		throw;
+	}
+}
+
+void MemfdSharedMemory::open(const std::string& name, const SharedMemoryOpenOptions& options)
+{
+	if (m_handle != 0)
+	{
+		throw std::runtime_error("Shared memory already opened.");
+	}
+
+	m_name = name;
+	m_readOnly = options.readOnly;
+	m_handle = ReceiveDescriptor(m_name);
+
+	// A sealed size is checked once below, an unsealed one could shrink under the mapping at any time
+	if ((fcntl(m_handle, F_GET_SEALS) & F_SEAL_SHRINK) == 0)
+	{
+		::close(m_handle);
+		m_handle = 0;
+		throw std::runtime_error("Shared memory size is not sealed.");
+	}
+
+	mapExisting(options);
+}
+
+void MemfdSharedMemory::close()
+{
+	stopServing();
+	PosixSharedMemory::close();
+}
+
+auto MemfdSharedMemory::createFile(const SegmentLayout& layout, unsigned int flags) -> void*
+{
+	m_handle = memfd_create(m_name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING | flags);
+
+	if (m_handle == -1)
+	{
+		m_handle = 0;
+		return MAP_FAILED;
+	}
+
+	m_size = layout.size;
+	m_pageSize = layout.pageSize;
+
+	// Huge pages are reserved when mapped, so a pool that is too small fails there
+	void* buffer {MAP_FAILED};
+
+	if (ftruncate(m_handle, static_cast<off_t>(m_size)) == 0 && fcntl(m_handle, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0)
+	{
+		buffer = map(layout.mirrorStart);
+	}
+
+	if (buffer == MAP_FAILED)
+	{
+		const int error {errno};
+		::close(m_handle);
+		m_handle = 0;
+		errno = error;
+	}
+
+	return buffer;
+}
+
+void MemfdSharedMemory::listen()
+{
+	socklen_t length {};
+	const sockaddr_un address {MakeSocketAddress(m_name, length)};
+
+	m_listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+	if (m_listener == -1)
+	{
+		throw std::runtime_error(std::format("Failed to create socket. Errno: {}", errno));
+	}
+
+	// Peers connecting before the server thread gets going wait in the backlog
+	if (bind(m_listener, reinterpret_cast<const sockaddr*>(&address), length) == -1 || ::listen(m_listener, SOMAXCONN) == -1)
+	{
+		const int error {errno};
+		::close(m_listener);
+		m_listener = -1;
+		throw std::runtime_error(std::format("Failed to bind shared memory socket. Errno: {}", error));
+	}
+
+	m_server = std::thread([this]() { serve(); });
+}
+
+void MemfdSharedMemory::serve()
+{
+	while (true)
+	{
+		const int connection {accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC)};
+
+		if (connection == -1)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+			{
+				continue;
+			}
+
+			// Shutting the listening socket down wakes accept with an error
+			return;
+		}
+
+		// Anyone can connect to an abstract socket, so only hand the segment to our own user
+		ucred credentials {};
+		socklen_t length {sizeof(credentials)};
+
+		if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 && credentials.uid == geteuid())
+		{
+			SendDescriptor(connection, m_handle);
+		}
+
+		::close(connection);
+	}
+}
+
+void MemfdSharedMemory::stopServing()
+{
+	if (m_listener == -1)
+	{
+		return;
+	}
+
+	shutdown(m_listener, SHUT_RDWR);
+
+	if (m_server.joinable())
+	{
+		m_server.join();
+	}
+
+	::close(m_listener);
+	m_listener = -1;
+}
+
+auto MemfdSharedMemory::unlink() -> int
+{
+	return 0;
+}
@@ -0,0 +1,94 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MEMFD_SHARED_MEMORY_H_
+#define MEMFD_SHARED_MEMORY_H_
+
+#include <libsmipc/shared-memory/platform/posix-shared-memory.hpp>
+
+#include <string>
+#include <thread>
+
+/**
+ * Shared memory in an anonymous memory file rather than a named segment.
+ *
+ * The creator keeps the segment's descriptor and hands it to every peer that
+ * asks for it over a Unix domain socket in the abstract namespace, named after
+ * the segment, with SCM_RIGHTS. Only peers running as the same user are
+ * answered. Neither the socket nor the segment outlive the processes using
+ * them, so a crash leaves nothing behind to clean up, and a peer can only open
+ * the segment while its creator has it open.
+ *
+ * The segment's size is sealed when it is created, so it can neither shrink
+ * nor grow under a peer's mapping, and is checked once when opening it rather
+ * than on every access. Huge pages come straight from the kernel's pool with
+ * MFD_HUGETLB, no hugetlbfs mount is needed.
+ */
+class MemfdSharedMemory final: public PosixSharedMemory
+{
+public:
+	~MemfdSharedMemory() override;
+
+	void create(const std::string& name, std::size_t size, const SharedMemoryOptions& options = {}) final;
+	void open(const std::string& name, const SharedMemoryOpenOptions& options = {}) final;
+	void close() final;
+
+private:
+	/**
+	 * Create, size, seal and map the memory file.
+	 *
+	 * @return The start of the mapping, or MAP_FAILED with errno set and
+	 * nothing left behind.
+	 */
+	[[nodiscard]]
+	auto createFile(const SegmentLayout& layout, unsigned int flags) -> void*;
+
+	/**
+	 * Bind the segment's socket and start handing out the descriptor.
+	 *
+	 * @throws std::runtime_error if the socket cannot be bound, typically
+	 * because a segment of the same name already exists.
+	 */
+	void listen();
+
+	/**
+	 * Hand the descriptor to each peer that connects until the listening
+	 * socket is shut down.
+	 */
+	void serve();
+
+	/**
+	 * Stop handing out the descriptor, peers that already have it keep it.
+	 */
+	void stopServing();
+
+	/**
+	 * The segment has no name to remove.
+	 */
+	auto unlink() -> int final;
+
+	int m_listener {-1};
+	std::thread m_server {};
+};
+
+#endif  // MEMFD_SHARED_MEMORY_H_
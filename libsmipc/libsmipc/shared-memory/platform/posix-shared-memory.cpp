@@ -26,12 +26,135 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <format>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <vector>
 
-void PosixSharedMemory::create(const std::string& name, std::size_t size)
+[[nodiscard]]
+auto PosixSharedMemory::GetLayout(std::size_t size, const SharedMemoryOptions& options, std::size_t pageSize, bool wholePages) -> SegmentLayout
+{
+	SegmentLayout layout {.size = size, .pageSize = pageSize};
+
+	if (wholePages || options.mirrored)
+	{
+		layout.size = (size + pageSize - 1u) / pageSize * pageSize;
+	}
+
+	if (options.mirrored)
+	{
+		// The mirrored part has to start on a page boundary, so the view header and
+		// the unmirrored start of the data region fill the pages in front of it
+		if (options.mirrorOffset % kSharedMemoryViewDataAlignment != 0u)
+		{
+			throw std::invalid_argument("Mirror offset must be 64 byte aligned.");
+		}
+
+		layout.mirrorStart = (kSharedMemoryViewDataOffset + options.mirrorOffset + pageSize - 1u) / pageSize * pageSize;
+
+		if (layout.size <= layout.mirrorStart)
+		{
+			throw std::invalid_argument("Shared memory is too small to be mirrored.");
+		}
+
+		layout.dataOffset = layout.mirrorStart - options.mirrorOffset;
+	}
+
+	return layout;
+}
+
+/**
+ * Find the hugetlbfs mounts, optionally only those handing out pages of one size.
+ */
+[[nodiscard]]
+static auto FindHugePageMounts(std::size_t pageSize = 0u) -> std::vector<std::string>
+{
+	std::vector<std::string> mounts;
+	std::ifstream mountTable {"/proc/mounts"};
+	std::string line;
+
+	while (std::getline(mountTable, line))
+	{
+		std::istringstream fields {line};
+		std::string device;
+		std::string mountPoint;
+		std::string type;
+
+		if (! (fields >> device >> mountPoint >> type) || type != "hugetlbfs")
+		{
+			continue;
+		}
+
+		struct statfs fileSystem {};
+
+		if (pageSize == 0u || (statfs(mountPoint.c_str(), &fileSystem) == 0 && static_cast<std::size_t>(fileSystem.f_bsize) == pageSize))
+		{
+			mounts.push_back(mountPoint);
+		}
+	}
+
+	return mounts;
+}
+
+// Memory policy modes and flags from linux/mempolicy.h, used through raw syscalls so libnuma is not needed
+static constexpr int kMemoryPolicyBind {2};
+static constexpr int kMemoryPolicyInterleave {3};
+static constexpr unsigned long kMemoryPolicyMemsAllowed {1u << 2u};
+
+static constexpr std::size_t kMaxNumaNodes {1024u};
+static constexpr std::size_t kNumaNodeMaskBits {8u * sizeof(unsigned long)};
+
+/**
+ * Apply a NUMA policy to a fresh mapping, before any of its pages are touched.
+ *
+ * Segments in /dev/shm keep the policy themselves, so pages faulted in later by
+ * any process follow it. Segments on hugetlbfs only keep it in this mapping.
+ * A kernel without NUMA support, or a node that does not exist or may not be
+ * used, leaves the pages to first touch.
+ */
+static void PlacePages(void* address, std::size_t size, NumaPolicy policy, uint32_t node)
+{
+#ifdef SYS_mbind
+	std::array<unsigned long, kMaxNumaNodes / kNumaNodeMaskBits> nodes {};
+	int mode {};
+
+	switch (policy)
+	{
+		case NumaPolicy::FirstTouch:
+			return;
+		case NumaPolicy::Bind:
+			if (node >= kMaxNumaNodes)
+			{
+				return;
+			}
+
+			nodes[node / kNumaNodeMaskBits] |= 1ul << (node % kNumaNodeMaskBits);
+			mode = kMemoryPolicyBind;
+			break;
+		case NumaPolicy::Interleave:
+			if (syscall(SYS_get_mempolicy, nullptr, nodes.data(), kMaxNumaNodes + 1u, nullptr, kMemoryPolicyMemsAllowed) == -1)
+			{
+				return;
+			}
+
+			mode = kMemoryPolicyInterleave;
+			break;
+	}
+
+	// The kernel drops the last bit of the node mask, hence one past the number of nodes
+	static_cast<void>(syscall(SYS_mbind, address, size, mode, nodes.data(), kMaxNumaNodes + 1u, 0u));
+#endif
+}
+
+void PosixSharedMemory::create(const std::string& name, std::size_t size, const SharedMemoryOptions& options)
 {
 	if (m_handle != 0)
 	{
@@ -39,28 +162,68 @@ void PosixSharedMemory::create(const std::string& name, std::size_t size)
 	}
 
 	m_name = name;
-	m_size = size;
+	m_readOnly = false;
 
-	// 1. Create shared memory mapping using the name as the id
-	m_handle = shm_open(m_name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	SegmentLayout layout {};
+	void* buffer {MAP_FAILED};
 
-	if (m_handle == -1)
+	// Huge pages are best effort, without a mount or enough free pages the segment gets normal ones
+	if (options.hugePageSize != 0u && options.hugePageSize != GetPageSize())
 	{
-		throw std::runtime_error(std::format("Failed to create file mapping object. Errno: {}", errno));
+		for (const auto& mount : FindHugePageMounts(options.hugePageSize))
+		{
+			layout = GetLayout(size, options, options.hugePageSize, true);
+			buffer = createHugePages(mount + m_name, layout);
+
+			if (buffer != MAP_FAILED)
+			{
+				break;
+			}
+		}
 	}
 
-	ftruncate(m_handle, m_size);
+	if (buffer == MAP_FAILED)
+	{
+		layout = GetLayout(size, options, GetPageSize(), false);
+		m_size = layout.size;
+		m_pageSize = layout.pageSize;
 
-	// 2. Create a file mapping of the shared memory
-	auto buffer = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
+		// 1. Create shared memory mapping using the name as the id
+		m_handle = shm_open(m_name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
 
-	if (reinterpret_cast<intptr_t>(buffer) == -1)
-	{
-		shm_unlink(m_name.c_str());
-		m_handle = 0u;
-		throw std::runtime_error(std::format("Failed to map view of file. Errno: {}", errno));
+		if (m_handle == -1)
+		{
+			throw std::runtime_error(std::format("Failed to create file mapping object. Errno: {}", errno));
+		}
+
+		ftruncate(m_handle, m_size);
+
+		// 2. Create a file mapping of the shared memory
+		buffer = map(layout.mirrorStart);
+
+		if (reinterpret_cast<intptr_t>(buffer) == -1)
+		{
+			const int error {errno};
+			shm_unlink(m_name.c_str());
+			::close(m_handle);
+			m_handle = 0u;
+			throw std::runtime_error(std::format("Failed to map view of file. Errno: {}", error));
+		}
+
+		// Only a hint, shared memory gets transparent huge pages where shmem_enabled is set to advise
+		if (options.hugePageSize != 0u)
+		{
+			madvise(buffer, m_mappedSize, MADV_HUGEPAGE);
+		}
 	}
 
+	initialiseView(buffer, layout, options);
+}
+
+void PosixSharedMemory::initialiseView(void* buffer, const SegmentLayout& layout, const SharedMemoryOptions& options)
+{
+	PlacePages(buffer, m_mappedSize, options.numaPolicy, options.numaNode);
+
 	m_buffer = reinterpret_cast<std::byte*>(buffer);
 
 	// Configure and initialise the shared memory view
@@ -73,14 +236,23 @@ void PosixSharedMemory::create(const std::string& name, std::size_t size)
 	*m_view.signals = 0u;
 	m_view.refCount = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewRefCountOffset);
 	*m_view.refCount = 1u;
-	m_view.dataSize = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
-	*m_view.dataSize = m_size - kSharedMemoryViewDataOffset;
-	m_view.data = m_buffer + kSharedMemoryViewDataOffset;
+	m_view.dataSize = reinterpret_cast<uint64_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
+	*m_view.dataSize = m_size - layout.dataOffset;
+	m_view.flags = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewFlagsOffset);
+	*m_view.flags = 0u;
+	m_view.flags->set(static_cast<uint32_t>(SharedMemoryFlag::Mirrored), options.mirrored);
+	m_view.dataOffset = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataOffsetOffset);
+	*m_view.dataOffset = layout.dataOffset;
+	m_view.mirrorStart = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewMirrorStartOffset);
+	*m_view.mirrorStart = layout.mirrorStart;
+	m_view.data = m_buffer + layout.dataOffset;
 
 	m_view.lock->clear(std::memory_order_release);
+
+	warmUp(options.prefault, options.lock, true);
 }
 
-void PosixSharedMemory::open(const std::string& name)
+void PosixSharedMemory::open(const std::string& name, const SharedMemoryOpenOptions& options)
 {
 	if (m_handle != 0)
 	{
@@ -88,72 +260,152 @@ void PosixSharedMemory::open(const std::string& name)
 	}
 
 	m_name = name;
+	m_readOnly = options.readOnly;
+
+	const int access {m_readOnly ? O_RDONLY : O_RDWR};
 
 	// 1. Open shared memory mapping using the name as the id
-	m_handle = shm_open(m_name.c_str(), O_RDWR | O_EXCL, S_IRUSR | S_IWUSR);
+	m_handle = shm_open(m_name.c_str(), access | O_EXCL, S_IRUSR | S_IWUSR);
+
+	// Segments backed by huge pages live on a hugetlbfs mount instead
+	if (m_handle == -1 && errno == ENOENT)
+	{
+		for (const auto& mount : FindHugePageMounts())
+		{
+			m_handle = ::open((mount + m_name).c_str(), access);
+
+			if (m_handle != -1)
+			{
+				m_path = mount + m_name;
+				break;
+			}
+		}
+
+		if (m_handle == -1)
+		{
+			errno = ENOENT;
+		}
+	}
 
 	if (m_handle == -1)
 	{
 		throw std::runtime_error(std::format("Failed to open file mapping object. Errno: {}", errno));
 	}
 
-	// Initially mmap just enough to read the header and get the size
-	auto tmp_buffer = mmap(nullptr, kSharedMemoryViewDataOffset, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
+	mapExisting(options);
+}
+
+void PosixSharedMemory::mapExisting(const SharedMemoryOpenOptions& options)
+{
+	// The block size of the file system backing the segment is its page size
+	struct statfs fileSystem {};
+	m_pageSize = fstatfs(m_handle, &fileSystem) == 0 ? static_cast<std::size_t>(fileSystem.f_bsize) : GetPageSize();
+
+	// Initially mmap just the first page to read the header and get the size
+	auto tmp_buffer = mmap(nullptr, m_pageSize, PROT_READ, MAP_SHARED, m_handle, 0);
 
 	if (reinterpret_cast<intptr_t>(tmp_buffer) == -1)
 	{
-		shm_unlink(m_name.c_str());
+		const int error {errno};
+
+		// Only a peer gives up on a segment it cannot map
+		if (! m_readOnly)
+		{
+			unlink();
+		}
+
+		::close(m_handle);
 		m_handle = 0u;
-		throw std::runtime_error(std::format("Failed to map view of file. Errno: {}", errno));
+		throw std::runtime_error(std::format("Failed to map view of file. Errno: {}", error));
 	}
 
-	m_size = *reinterpret_cast<uint32_t*>(reinterpret_cast<std::byte*>(tmp_buffer) + kSharedMemoryViewDataSizeOffset) + kSharedMemoryViewDataOffset;
+	const auto* header = reinterpret_cast<const std::byte*>(tmp_buffer);
+	const uint32_t dataOffset {*reinterpret_cast<const uint32_t*>(header + kSharedMemoryViewDataOffsetOffset)};
+	const uint32_t mirrorStart {*reinterpret_cast<const uint32_t*>(header + kSharedMemoryViewMirrorStartOffset)};
+	m_size = *reinterpret_cast<const uint64_t*>(header + kSharedMemoryViewDataSizeOffset) + dataOffset;
 
-	if (munmap(tmp_buffer, m_size) == -1)
+	if (munmap(tmp_buffer, m_pageSize) == -1)
 	{
-		throw std::runtime_error(std::format("Failed to unmap view of file. Errno: {}", errno));
+		const int error {errno};
+		::close(m_handle);
+		m_handle = 0u;
+		throw std::runtime_error(std::format("Failed to unmap view of file. Errno: {}", error));
 	}
 
-	// 2. Create a file mapping of the shared memory
-	auto buffer = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
+	// Checked once here, a segment cut short would only show up as SIGBUS on access
+	struct stat file {};
+
+	if (fstat(m_handle, &file) == -1 || static_cast<std::size_t>(file.st_size) < m_size)
+	{
+		::close(m_handle);
+		m_handle = 0u;
+		throw std::runtime_error("Shared memory is smaller than its header claims.");
+	}
+
+	// 2. Create a file mapping of the shared memory, mirroring from where the creator started the mirror
+	auto buffer = map(mirrorStart);
 
 	if (reinterpret_cast<intptr_t>(buffer) == -1)
 	{
-		shm_unlink(m_name.c_str());
+		const int error {errno};
+
+		// Only a peer gives up on a segment it cannot map
+		if (! m_readOnly)
+		{
+			unlink();
+		}
+
+		::close(m_handle);
 		m_handle = 0u;
-		throw std::runtime_error(std::format("Failed to map view of file. Errno: {}", errno));
+		throw std::runtime_error(std::format("Failed to map view of file. Errno: {}", error));
 	}
 
 	m_buffer = reinterpret_cast<std::byte*>(buffer);
 
 	// Configure the shared memory view
 	m_view.lock = reinterpret_cast<std::atomic_flag*>(m_buffer + kSharedMemoryViewLockOffset);
-
-	while (m_view.lock->test_and_set(std::memory_order_acquire));
-
 	m_view.signals = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewSignalsOffset);
 	m_view.refCount = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewRefCountOffset);
-	(*m_view.refCount)++;
-	m_view.dataSize = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
-	m_view.data = m_buffer + kSharedMemoryViewDataOffset;
+	m_view.dataSize = reinterpret_cast<uint64_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
+	m_view.flags = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewFlagsOffset);
+	m_view.dataOffset = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataOffsetOffset);
+	m_view.mirrorStart = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewMirrorStartOffset);
+	m_view.data = m_buffer + dataOffset;
+
+	// A read-only view cannot take the lock and does not hold a reference
+	if (! m_readOnly)
+	{
+		while (m_view.lock->test_and_set(std::memory_order_acquire));
+		(*m_view.refCount)++;
+		m_view.lock->clear(std::memory_order_release);
+	}
 
-	m_view.lock->clear(std::memory_order_release);
+	warmUp(options.prefault, options.lock, false);
 }
 
 void PosixSharedMemory::close()
 {
-	while (m_view.lock->test_and_set(std::memory_order_acquire));
+	// An observer leaves the segment to the peers using it
+	release(! m_readOnly);
+}
 
-	if (*m_view.refCount > 0)
+void PosixSharedMemory::release(bool unlinkName)
+{
+	if (! m_readOnly)
 	{
-		--(*m_view.refCount);
-	}
+		while (m_view.lock->test_and_set(std::memory_order_acquire));
 
-	m_view.lock->clear(std::memory_order_release);
+		if (*m_view.refCount > 0)
+		{
+			--(*m_view.refCount);
+		}
+
+		m_view.lock->clear(std::memory_order_release);
+	}
 
 	if (m_buffer)
 	{
-		if (munmap(m_buffer, m_size) == -1)
+		if (munmap(m_buffer, m_mappedSize) == -1)
 		{
 			throw std::runtime_error(std::format("Failed to unmap view of file. Errno: {}", errno));
 		}
@@ -164,7 +416,7 @@ void PosixSharedMemory::close()
 
 	if (m_handle > 0)
 	{
-		if (shm_unlink(m_name.c_str()))
+		if (unlinkName && unlink())
 		{
 			// I wouldn't expect the file to be missing here, will need to investigate further
 			if (errno != ENOENT)
@@ -173,12 +425,23 @@ void PosixSharedMemory::close()
 			}
 		}
 
+		// An open descriptor keeps an unlinked hugetlbfs file, and its reserved pages, alive
+		::close(m_handle);
 		m_handle = 0u;
 	}
+
+	m_readOnly = false;
 }
 
 void PosixSharedMemory::closeAll()
 {
+	// An observer holds no reference and cannot signal anyone
+	if (m_readOnly)
+	{
+		close();
+		return;
+	}
+
 	while (m_view.lock->test_and_set(std::memory_order_acquire));
 	m_view.signals->set(static_cast<uint32_t>(Signal::Close));
 	m_view.lock->clear(std::memory_order_release);
@@ -203,6 +466,16 @@ auto PosixSharedMemory::getSize() const -> std::size_t
 	return m_size;
 }
 
+auto PosixSharedMemory::isMirrored() const -> bool
+{
+	return m_view.flags != nullptr && m_view.flags->test(static_cast<uint32_t>(SharedMemoryFlag::Mirrored));
+}
+
+auto PosixSharedMemory::getPageSize() const -> std::size_t
+{
+	return m_pageSize;
+}
+
 auto PosixSharedMemory::getView() -> SharedMemoryView
 {
 	return m_view;
@@ -212,3 +485,192 @@ auto PosixSharedMemory::getView() const -> const SharedMemoryView
 {
 	return m_view;
 }
+
+auto PosixSharedMemory::getWarmUpTime() const -> std::chrono::nanoseconds
+{
+	return m_warmUpTime;
+}
+
+auto PosixSharedMemory::getNumaNode() const -> int
+{
+#ifdef SYS_move_pages
+	if (m_buffer == nullptr)
+	{
+		return -1;
+	}
+
+	std::vector<void*> pages;
+
+	for (std::size_t offset = 0u; offset < m_size; offset += m_pageSize)
+	{
+		pages.push_back(m_buffer + offset);
+	}
+
+	// Without target nodes move_pages only reports the node of each page, or an error for those not in memory
+	std::vector<int> status(pages.size());
+
+	if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) == -1)
+	{
+		return -1;
+	}
+
+	std::vector<std::size_t> pageCounts;
+
+	for (const int node : status)
+	{
+		if (node >= 0)
+		{
+			pageCounts.resize(std::max(pageCounts.size(), static_cast<std::size_t>(node) + 1u));
+			++pageCounts[static_cast<std::size_t>(node)];
+		}
+	}
+
+	if (pageCounts.empty())
+	{
+		return -1;
+	}
+
+	return static_cast<int>(std::distance(pageCounts.begin(), std::max_element(pageCounts.begin(), pageCounts.end())));
+#else
+	return -1;
+#endif
+}
+
+auto PosixSharedMemory::GetPageSize() -> std::size_t
+{
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+auto PosixSharedMemory::createHugePages(const std::string& path, const SegmentLayout& layout) -> void*
+{
+	m_handle = ::open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+
+	if (m_handle == -1)
+	{
+		m_handle = 0;
+		return MAP_FAILED;
+	}
+
+	m_size = layout.size;
+	m_pageSize = layout.pageSize;
+
+	// Huge pages are reserved when mapped, so a pool that is too small fails here
+	void* buffer {ftruncate(m_handle, static_cast<off_t>(m_size)) == 0 ? map(layout.mirrorStart) : MAP_FAILED};
+
+	if (buffer == MAP_FAILED)
+	{
+		::close(m_handle);
+		::unlink(path.c_str());
+		m_handle = 0;
+		return MAP_FAILED;
+	}
+
+	// Openers look in /dev/shm first, so a stale segment of the same name there would shadow this one
+	shm_unlink(m_name.c_str());
+
+	m_path = path;
+	return buffer;
+}
+
+void PosixSharedMemory::warmUp(bool prefault, bool lock, bool created)
+{
+	m_warmUpTime = std::chrono::nanoseconds::zero();
+
+	if (! prefault && ! lock)
+	{
+		return;
+	}
+
+	const auto start {std::chrono::steady_clock::now()};
+
+	if (prefault)
+	{
+#ifdef MADV_POPULATE_WRITE
+		// Faults every page in writable without touching its contents, the peer may already be using them
+		const bool populated {madvise(m_buffer, m_mappedSize, MADV_POPULATE_WRITE) == 0};
+#else
+		const bool populated {false};
+#endif
+
+		// Kernels before 5.14 lack it, reading a byte of each page maps it all the same
+		if (! populated)
+		{
+			for (std::size_t offset = 0u; offset < m_mappedSize; offset += m_pageSize)
+			{
+				static_cast<void>(*reinterpret_cast<volatile const std::byte*>(m_buffer + offset));
+			}
+		}
+	}
+
+	if (lock && mlock(m_buffer, m_mappedSize) == -1)
+	{
+		const int error {errno};
+
+		// A peer that cannot lock its view gives up on it, the segment stays with the others using it
+		release(created);
+		throw std::runtime_error(std::format("Failed to lock shared memory. Errno: {}", error));
+	}
+
+	m_warmUpTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+}
+
+auto PosixSharedMemory::unlink() -> int
+{
+	return m_path.empty() ? shm_unlink(m_name.c_str()) : ::unlink(m_path.c_str());
+}
+
+auto PosixSharedMemory::map(std::size_t mirrorStart) -> void*
+{
+	const int protection {m_readOnly ? PROT_READ : PROT_READ | PROT_WRITE};
+
+	if (mirrorStart == 0u)
+	{
+		m_mappedSize = m_size;
+		return mmap(nullptr, m_size, protection, MAP_SHARED, m_handle, 0);
+	}
+
+	const std::size_t mirrorSize {m_size - mirrorStart};
+
+	// Huge pages can only be mapped at addresses aligned to their size, reserve enough to line one up
+	const std::size_t slack {m_pageSize > GetPageSize() ? m_pageSize : 0u};
+
+	// Reserve room for the segment and its mirror up front so nothing else can be mapped in between
+	auto reserved = mmap(nullptr, m_size + mirrorSize + slack, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (reserved == MAP_FAILED)
+	{
+		return MAP_FAILED;
+	}
+
+	auto* base = reinterpret_cast<std::byte*>(reserved);
+
+	if (slack > 0u)
+	{
+		const std::size_t head {(m_pageSize - reinterpret_cast<uintptr_t>(reserved) % m_pageSize) % m_pageSize};
+
+		if (head > 0u)
+		{
+			munmap(reserved, head);
+		}
+
+		if (slack > head)
+		{
+			munmap(base + head + m_size + mirrorSize, slack - head);
+		}
+
+		base += head;
+		reserved = base;
+	}
+
+	if (mmap(base, m_size, protection, MAP_SHARED | MAP_FIXED, m_handle, 0) == MAP_FAILED
+		|| mmap(base + m_size, mirrorSize, protection, MAP_SHARED | MAP_FIXED, m_handle, static_cast<off_t>(mirrorStart)) == MAP_FAILED)
+	{
+		const int error {errno};
+		munmap(reserved, m_size + mirrorSize);
+		errno = error;
+		return MAP_FAILED;
+	}
+
+	m_mappedSize = m_size + mirrorSize;
+	return reserved;
+}
@@ -27,6 +27,7 @@
 #include <libsmipc/shared-memory/abstract-shared-memory.hpp>
 #include <libsmipc/shared-memory/shared-memory-view.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -34,21 +35,114 @@
 class PosixSharedMemory: public ISharedMemory
 {
 public:
-	void create(const std::string& name, std::size_t size) final;
-	void open(const std::string& name) final;
-	void close() final;
+	void create(const std::string& name, std::size_t size, const SharedMemoryOptions& options = {}) override;
+	void open(const std::string& name, const SharedMemoryOpenOptions& options = {}) override;
+	void close() override;
 	void closeAll() final;
 	auto getName() const -> std::string_view final;
 	auto getSize() const -> std::size_t final;
+	auto isMirrored() const -> bool final;
+	auto getPageSize() const -> std::size_t final;
+	auto getWarmUpTime() const -> std::chrono::nanoseconds final;
+	auto getNumaNode() const -> int final;
 	auto getView() -> SharedMemoryView final;
 	auto getView() const -> const SharedMemoryView final;
 
-private:
+protected:
+	/**
+	 * Where a segment's data region starts and where its mirror, if any,
+	 * begins, for a given page size.
+	 */
+	struct SegmentLayout
+	{
+		std::size_t size {};
+		std::size_t pageSize {};
+		std::size_t dataOffset {kSharedMemoryViewDataOffset};
+		std::size_t mirrorStart {0u};
+	};
+
+	[[nodiscard]]
+	static auto GetPageSize() -> std::size_t;
+
+	/**
+	 * Lay out a segment of at least `size` bytes, rounded up to whole pages
+	 * when mirrored or when `wholePages` is set.
+	 *
+	 * @throws std::invalid_argument if the mirror offset is misaligned or
+	 * leaves nothing to mirror.
+	 */
+	[[nodiscard]]
+	static auto GetLayout(std::size_t size, const SharedMemoryOptions& options, std::size_t pageSize, bool wholePages) -> SegmentLayout;
+
+	/**
+	 * Map the segment, mapping everything from `mirrorStart` on a second time
+	 * directly behind it when `mirrorStart` is not zero.
+	 *
+	 * @return The start of the mapping, or MAP_FAILED with errno set.
+	 */
+	[[nodiscard]]
+	auto map(std::size_t mirrorStart) -> void*;
+
+	/**
+	 * Lay the view out in a freshly created and mapped segment, applying the
+	 * NUMA policy first and warming the mapping up afterwards.
+	 */
+	void initialiseView(void* buffer, const SegmentLayout& layout, const SharedMemoryOptions& options);
+
+	/**
+	 * Map an existing segment through the open handle, taking its size and
+	 * layout from the view header, and warm the mapping up.
+	 *
+	 * @throws std::runtime_error if the segment cannot be mapped or is
+	 * smaller than its header claims.
+	 */
+	void mapExisting(const SharedMemoryOpenOptions& options);
+
+	/**
+	 * Remove the segment's name, wherever it lives.
+	 */
+	virtual auto unlink() -> int;
+
 	std::size_t m_size {};
+	std::size_t m_mappedSize {};
+	std::size_t m_pageSize {};
 	std::string m_name {};
 	int m_handle {};
 	std::byte* m_buffer {nullptr};
 	SharedMemoryView m_view {};
+	bool m_readOnly {false};
+
+private:
+	/**
+	 * Create and map the segment as a file on a hugetlbfs mount.
+	 *
+	 * @return The start of the mapping, or MAP_FAILED with nothing left
+	 * behind if the mount cannot supply the pages.
+	 */
+	[[nodiscard]]
+	auto createHugePages(const std::string& path, const SegmentLayout& layout) -> void*;
+
+	/**
+	 * Drop this side's reference, unmap the segment and close its descriptor,
+	 * removing the segment's name as well when asked to.
+	 *
+	 * @throws std::runtime_error if the segment cannot be unmapped or its
+	 * name cannot be removed.
+	 */
+	void release(bool unlinkName);
+
+	/**
+	 * Fault the mapping in and lock it in memory as asked, timing both.
+	 *
+	 * @throws std::runtime_error if the mapping cannot be locked, typically
+	 * for lack of RLIMIT_MEMLOCK, after letting go of the segment again. Only
+	 * the side that `created` the segment removes its name.
+	 */
+	void warmUp(bool prefault, bool lock, bool created);
+
+	std::chrono::nanoseconds m_warmUpTime {};
+	// The file backing a huge page segment, empty for segments in /dev/shm
+	std::string m_path {};
 };
 
 #endif  // POSIX_SHARED_MEMORY_H_
\ No newline at end of file
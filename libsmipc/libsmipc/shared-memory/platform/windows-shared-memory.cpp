@@ -23,24 +23,36 @@
 
 #include <libsmipc/shared-memory/platform/windows-shared-memory.hpp>
 
+#include <chrono>
 #include <format>
 #include <stdexcept>
 #include <windows.h>
 
-void WindowsSharedMemory::create(const std::string& name, std::size_t size)
+void WindowsSharedMemory::create(const std::string& name, std::size_t size, const SharedMemoryOptions& options)
 {
 	if (m_handle != 0)
 	{
 		throw std::runtime_error("Shared memory already created.");
 	}
 
+	if (options.mirrored)
+	{
+		throw std::invalid_argument("Mirrored shared memory is not supported on this platform.");
+	}
+
 	m_name = name;
+	m_readOnly = false;
 	m_size = size;
 
 	const uint32_t low_size {static_cast<uint32_t>(m_size & 0xFFFFFFFF)};
 	const uint32_t high_size {static_cast<uint32_t>((m_size >> 32) & 0xFFFFFFFF)};
 
-	m_handle = reinterpret_cast<std::uintptr_t>(CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, high_size, low_size, m_name.c_str()));
+	// Only binding is available, other policies and nodes that do not exist leave the pages to first touch
+	ULONG highestNode {};
+	const bool bind {options.numaPolicy == NumaPolicy::Bind && GetNumaHighestNodeNumber(&highestNode) && options.numaNode <= highestNode};
+	const DWORD preferredNode {bind ? static_cast<DWORD>(options.numaNode) : NUMA_NO_PREFERRED_NODE};
+
+	m_handle = reinterpret_cast<std::uintptr_t>(CreateFileMappingNumaA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, high_size, low_size, m_name.c_str(), preferredNode));
 
 	if (reinterpret_cast<HANDLE>(m_handle) == nullptr)
 	{
@@ -66,14 +78,22 @@ void WindowsSharedMemory::create(const std::string& name, std::size_t size)
 	*m_view.signals = 0u;
 	m_view.refCount = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewRefCountOffset);
 	*m_view.refCount = 1u;
-	m_view.dataSize = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
+	m_view.dataSize = reinterpret_cast<uint64_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
 	*m_view.dataSize = m_size - kSharedMemoryViewDataOffset;
+	m_view.flags = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewFlagsOffset);
+	*m_view.flags = 0u;
+	m_view.dataOffset = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataOffsetOffset);
+	*m_view.dataOffset = kSharedMemoryViewDataOffset;
+	m_view.mirrorStart = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewMirrorStartOffset);
+	*m_view.mirrorStart = 0u;
 	m_view.data = m_buffer + kSharedMemoryViewDataOffset;
 
 	m_view.lock->clear(std::memory_order_release);
+
+	warmUp(options.prefault, options.lock);
 }
 
-void WindowsSharedMemory::open(const std::string& name)
+void WindowsSharedMemory::open(const std::string& name, const SharedMemoryOpenOptions& options)
 {
 	if (m_handle != 0)
 	{
@@ -81,15 +101,18 @@ void WindowsSharedMemory::open(const std::string& name)
 	}
 
 	m_name = name;
+	m_readOnly = options.readOnly;
+
+	const DWORD access {m_readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS};
 
-	m_handle = reinterpret_cast<std::uintptr_t>(OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_name.c_str()));
+	m_handle = reinterpret_cast<std::uintptr_t>(OpenFileMappingA(access, FALSE, m_name.c_str()));
 
 	if (reinterpret_cast<HANDLE>(m_handle) == nullptr)
 	{
 		throw std::runtime_error(std::format("Failed to open file mapping object. Error code: {}", GetLastError()));
 	}
 
-	m_buffer = static_cast<std::byte*>(MapViewOfFile(reinterpret_cast<HANDLE>(m_handle), FILE_MAP_ALL_ACCESS, 0, 0, m_size));
+	m_buffer = static_cast<std::byte*>(MapViewOfFile(reinterpret_cast<HANDLE>(m_handle), access, 0, 0, m_size));
 
 	if (m_buffer == nullptr)
 	{
@@ -100,29 +123,40 @@ void WindowsSharedMemory::open(const std::string& name)
 
 	// Configure the shared memory view
 	m_view.lock = reinterpret_cast<std::atomic_flag*>(m_buffer + kSharedMemoryViewLockOffset);
-
-	while (m_view.lock->test_and_set(std::memory_order_acquire));
-
 	m_view.signals = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewSignalsOffset);
 	m_view.refCount = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewRefCountOffset);
-	(*m_view.refCount)++;
-	m_view.dataSize = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
-	m_size = *m_view.dataSize + kSharedMemoryViewDataOffset;
-	m_view.data = m_buffer + kSharedMemoryViewDataOffset;
 
-	m_view.lock->clear(std::memory_order_release);
+	// A read-only view cannot take the lock and does not hold a reference
+	if (! m_readOnly)
+	{
+		while (m_view.lock->test_and_set(std::memory_order_acquire));
+		(*m_view.refCount)++;
+		m_view.lock->clear(std::memory_order_release);
+	}
+
+	m_view.dataSize = reinterpret_cast<uint64_t*>(m_buffer + kSharedMemoryViewDataSizeOffset);
+	m_view.flags = reinterpret_cast<std::bitset<32u>*>(m_buffer + kSharedMemoryViewFlagsOffset);
+	m_view.dataOffset = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewDataOffsetOffset);
+	m_view.mirrorStart = reinterpret_cast<uint32_t*>(m_buffer + kSharedMemoryViewMirrorStartOffset);
+	m_size = *m_view.dataSize + *m_view.dataOffset;
+	m_view.data = m_buffer + *m_view.dataOffset;
+
+	warmUp(options.prefault, options.lock);
 }
 
 void WindowsSharedMemory::close()
 {
-	while(m_view.lock->test_and_set(std::memory_order_acquire));
-
-	if (*m_view.refCount > 0)
+	if (! m_readOnly)
 	{
-		--(*m_view.refCount);
-	}
+		while(m_view.lock->test_and_set(std::memory_order_acquire));
 
-	m_view.lock->clear(std::memory_order_release);
+		if (*m_view.refCount > 0)
+		{
+			--(*m_view.refCount);
+		}
+
+		m_view.lock->clear(std::memory_order_release);
+	}
 
 	if (m_buffer)
 	{
@@ -136,12 +170,14 @@ void WindowsSharedMemory::close()
 		CloseHandle(reinterpret_cast<HANDLE>(m_handle));
 		m_handle = 0u;
 	}
+
+	m_readOnly = false;
 }
 
 void WindowsSharedMemory::closeAll()
 {
-	// First close any existing views
-	if (*m_view.refCount > 1)
+	// First close any existing views, an observer has none to wait for
+	if (! m_readOnly && *m_view.refCount > 1)
 	{
 		while (m_view.lock->test_and_set(std::memory_order_acquire));
 		m_view.signals->set(static_cast<uint32_t>(Signal::Close));
@@ -167,6 +203,72 @@ auto WindowsSharedMemory::getSize() const -> std::size_t
 	return m_size;
 }
 
+auto WindowsSharedMemory::isMirrored() const -> bool
+{
+	return false;
+}
+
+auto WindowsSharedMemory::getPageSize() const -> std::size_t
+{
+	SYSTEM_INFO systemInfo {};
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwPageSize;
+}
+
+auto WindowsSharedMemory::getWarmUpTime() const -> std::chrono::nanoseconds
+{
+	return m_warmUpTime;
+}
+
+void WindowsSharedMemory::warmUp(bool prefault, bool lock)
+{
+	m_warmUpTime = std::chrono::nanoseconds::zero();
+
+	if (! prefault && ! lock)
+	{
+		return;
+	}
+
+	const auto start {std::chrono::steady_clock::now()};
+
+	if (prefault)
+	{
+		// Reading a byte of each page maps it without disturbing a peer already using it
+		const std::size_t pageSize {getPageSize()};
+
+		for (std::size_t offset = 0u; offset < m_size; offset += pageSize)
+		{
+			static_cast<void>(*reinterpret_cast<volatile const std::byte*>(m_buffer + offset));
+		}
+	}
+
+	if (lock)
+	{
+		// Locked pages count against the minimum working set, which is small by default
+		SIZE_T minimumSize {};
+		SIZE_T maximumSize {};
+
+		if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimumSize, &maximumSize))
+		{
+			SetProcessWorkingSetSize(GetCurrentProcess(), minimumSize + m_size, maximumSize + m_size);
+		}
+	}
+
+	if (lock && ! VirtualLock(m_buffer, m_size))
+	{
+		const auto errorCode = GetLastError();
+		close();
+		throw std::runtime_error(std::format("Failed to lock view of file. Error code: {}", errorCode));
+	}
+
+	m_warmUpTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+}
+
+auto WindowsSharedMemory::getNumaNode() const -> int
+{
+	return -1;
+}
+
 auto WindowsSharedMemory::getView() -> SharedMemoryView
 {
 	return m_view;
@@ -27,6 +27,7 @@
 #include <libsmipc/shared-memory/abstract-shared-memory.hpp>
 #include <libsmipc/shared-memory/shared-memory-view.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -34,21 +35,35 @@
 class WindowsSharedMemory: public ISharedMemory
 {
 public:
-	void create(const std::string& name, std::size_t size) final;
-	void open(const std::string& name) final;
+	void create(const std::string& name, std::size_t size, const SharedMemoryOptions& options = {}) final;
+	void open(const std::string& name, const SharedMemoryOpenOptions& options = {}) final;
 	void close() final;
 	void closeAll() final;
 	auto getName() const -> std::string_view final;
 	auto getSize() const -> std::size_t final;
+	auto isMirrored() const -> bool final;
+	auto getPageSize() const -> std::size_t final;
+	auto getWarmUpTime() const -> std::chrono::nanoseconds final;
+	auto getNumaNode() const -> int final;
 	auto getView() -> SharedMemoryView final;
 	auto getView() const -> const SharedMemoryView final;
 
 private:
+	/**
+	 * Fault the view in and lock it in memory as asked, timing both.
+	 *
+	 * @throws std::runtime_error if the view cannot be locked, after closing
+	 * the segment again.
+	 */
+	void warmUp(bool prefault, bool lock);
+
 	std::size_t m_size {};
 	std::string m_name {};
 	std::uintptr_t m_handle {};
 	std::byte* m_buffer {nullptr};
+	std::chrono::nanoseconds m_warmUpTime {};
 	SharedMemoryView m_view {};
+	bool m_readOnly {false};
 };
 
 #endif  // WINDOWS_SHARED_MEMORY_H_
\ No newline at end of file
@@ -28,16 +28,23 @@
 #include <libsmipc/ring-buffer/rx-ring-buffer.hpp>
 #include <libsmipc/ring-buffer/packet.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <cstdint>
+#include <utility>
 
 class RxSharedMemoryPipe
 {
 public:
-	RxSharedMemoryPipe(std::unique_ptr<ISharedMemory>&& sharedMemory)
+	RxSharedMemoryPipe(std::unique_ptr<ISharedMemory>&& sharedMemory, const RingBufferOptions& options = {})
 		: m_sharedMemory {std::move(sharedMemory)}
-		, m_ringBuffer {reinterpret_cast<uint8_t*>(m_sharedMemory->getView().data), m_sharedMemory->getSize()}
+		, m_ringBuffer {reinterpret_cast<uint8_t*>(m_sharedMemory->getView().data), static_cast<std::size_t>(*m_sharedMemory->getView().dataSize), MakeRingBufferOptions(options, *m_sharedMemory)}
 	{}
 
 	~RxSharedMemoryPipe() 
@@ -49,6 +56,85 @@ public:
 		return m_ringBuffer.pull();
 	}
 
+	[[nodiscard]]
+	auto read(std::chrono::nanoseconds timeout) -> std::optional<Packet>
+	{
+		return m_ringBuffer.pull(timeout);
+	}
+
+	[[nodiscard]]
+	auto tryRead(Packet& packet) -> RingBufferStatus
+	{
+		return m_ringBuffer.tryPull(packet);
+	}
+
+	/**
+	 * Read the next message, reassembling it from the fragments sent by
+	 * TxSharedMemoryPipe::writeMessage.
+	 *
+	 * Each fragment is copied straight out of the ring into `message`, which
+	 * reuses its storage and takes larger blocks from the packet buffer pool,
+	 * so the writer can keep filling the ring while earlier fragments are read.
+	 * Packets sent with write() read as messages of one fragment. If the
+	 * timeout runs out part way, the fragments read so far are kept and the
+	 * next call with the same buffer carries on.
+	 *
+	 * @param message Receives the message.
+	 * @param timeout How long to wait for the rest of the message.
+	 * @return False if the timeout ran out before the message was complete.
+	 * @throws std::runtime_error if checksums are enabled and a fragment does
+	 * not match its checksum, the rest of the message is dropped.
+	 */
+	[[nodiscard]]
+	auto readMessage(PacketBuffer& message, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) -> bool
+	{
+		return readFragments(timeout, [&message](std::size_t size, std::size_t expectedSize) -> std::span<uint8_t>
+			{
+				message.reserve(expectedSize);
+				message.resize(size);
+				return message;
+			}).has_value();
+	}
+
+	/**
+	 * Read the next message into a caller provided buffer.
+	 *
+	 * @see readMessage(PacketBuffer&, std::chrono::nanoseconds)
+	 * @return The size of the message, or nothing if the timeout ran out.
+	 * @throws std::length_error if the message does not fit, the rest of it is
+	 * dropped.
+	 */
+	[[nodiscard]]
+	auto readMessage(std::span<uint8_t> destination, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) -> std::optional<std::size_t>
+	{
+		return readFragments(timeout, [destination](std::size_t size, std::size_t) -> std::span<uint8_t>
+			{
+				if (size > destination.size())
+				{
+					throw std::length_error("Message does not fit in the destination");
+				}
+
+				return destination;
+			});
+	}
+
+	[[nodiscard]]
+	auto peek() const -> PacketView
+	{
+		return m_ringBuffer.peek();
+	}
+
+	void release()
+	{
+		m_ringBuffer.release();
+	}
+
+	template <class Handler>
+	auto drain(Handler&& handler, std::size_t maxPackets = std::numeric_limits<std::size_t>::max()) -> std::size_t
+	{
+		return m_ringBuffer.drain(std::forward<Handler>(handler), maxPackets);
+	}
+
 	auto getSharedMemory() const -> const ISharedMemory*
 	{
 		return m_sharedMemory.get();
@@ -60,8 +146,87 @@ public:
 	}
 
 private:
+	// The segment decides whether the ring buffer is mirrored, the caller decides the rest
+	static auto MakeRingBufferOptions(RingBufferOptions options, const ISharedMemory& sharedMemory) -> RingBufferOptions
+	{
+		options.mirrored = sharedMemory.isMirrored();
+		return options;
+	}
+
+	// The message being reassembled, kept across calls that time out
+	struct Transfer
+	{
+		uint32_t transferId {};
+		uint32_t packetCount {};
+		uint32_t nextPacketId {};
+		std::size_t size {};
+	};
+
+	auto readFragments(std::chrono::nanoseconds timeout, auto getDestination) -> std::optional<std::size_t>
+	{
+		const auto start {std::chrono::steady_clock::now()};
+
+		while (true)
+		{
+			const auto elapsed {std::chrono::steady_clock::now() - start};
+			const auto remaining {timeout == std::chrono::nanoseconds::max() ? timeout : std::max(std::chrono::nanoseconds {0}, timeout - elapsed)};
+
+			if (! m_ringBuffer.wait(remaining))
+			{
+				return std::nullopt;
+			}
+
+			const PacketView view {m_ringBuffer.peek()};
+			const PacketHeader& packetHeader {view.header};
+
+			// A first fragment, or a packet that was never split, starts a new message
+			if (packetHeader.packetId == 0u || packetHeader.packetCount <= 1u)
+			{
+				m_transfer = Transfer {packetHeader.transferId, std::max(packetHeader.packetCount, 1u), 0u, 0u};
+			}
+			else if (! m_transfer || packetHeader.transferId != m_transfer->transferId || packetHeader.packetId != m_transfer->nextPacketId)
+			{
+				// Left over from a transfer the writer gave up on, or one that was dropped
+				m_ringBuffer.release();
+				continue;
+			}
+
+			const std::size_t size {m_transfer->size + packetHeader.size};
+			std::span<uint8_t> destination {};
+
+			try
+			{
+				destination = getDestination(size, static_cast<std::size_t>(m_transfer->packetCount) * packetHeader.size);
+			}
+			catch (...)
+			{
+				m_transfer.reset();
+				m_ringBuffer.release();
+				throw;
+			}
+
+			const bool verified {m_ringBuffer.copyPayload(destination.subspan(m_transfer->size, packetHeader.size))};
+			m_ringBuffer.release();
+
+			if (! verified)
+			{
+				m_transfer.reset();
+				throw std::runtime_error("Packet checksum mismatch");
+			}
+
+			m_transfer->size = size;
+
+			if (++m_transfer->nextPacketId == m_transfer->packetCount)
+			{
+				m_transfer.reset();
+				return size;
+			}
+		}
+	}
+
 	std::unique_ptr<ISharedMemory> m_sharedMemory;
 	RxRingBuffer m_ringBuffer;
+	std::optional<Transfer> m_transfer {};
 };
 
 #endif  // RX_SHARED_MEMORY_PIPE_H_
@@ -28,11 +28,26 @@
 #elif _WIN32
 #	include <libsmipc/shared-memory/platform/windows-shared-memory.hpp>
 #elif __linux__
+#	include <libsmipc/shared-memory/platform/memfd-shared-memory.hpp>
 #	include <libsmipc/shared-memory/platform/posix-shared-memory.hpp>
 #endif
 
-std::unique_ptr<ISharedMemory> MakeUniqueSharedMemory()
+#include <stdexcept>
+
+std::unique_ptr<ISharedMemory> MakeUniqueSharedMemory(SharedMemoryBackend backend)
 {
+	#ifdef __linux__
+		if (backend == SharedMemoryBackend::Memfd)
+		{
+			return std::make_unique<MemfdSharedMemory>();
+		}
+	#endif
+
+	if (backend != SharedMemoryBackend::Named)
+	{
+		throw std::invalid_argument("Shared memory backend is not supported on this platform.");
+	}
+
 	#ifdef _INTIME
 		return std::make_unique<IntimeSharedMemory>();
 	#elif _WIN32
@@ -28,7 +28,12 @@
 
 #include <memory>
 
+/**
+ * Make a shared memory segment for this platform.
+ *
+ * @throws std::invalid_argument if the platform does not support the backend.
+ */
 [[nodiscard]]
-std::unique_ptr<ISharedMemory> MakeUniqueSharedMemory();
+std::unique_ptr<ISharedMemory> MakeUniqueSharedMemory(SharedMemoryBackend backend = SharedMemoryBackend::Named);
 
 #endif  // SHARED_MEMORY_FACTORY_HPP_
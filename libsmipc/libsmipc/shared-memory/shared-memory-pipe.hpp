@@ -29,16 +29,20 @@
 #include <libsmipc/shared-memory/rx-shared-memory-pipe.hpp>
 #include <libsmipc/shared-memory/tx-shared-memory-pipe.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 
 class SharedMemoryPipe
 {
 public:
-	SharedMemoryPipe(std::unique_ptr<ISharedMemory>&& rxSharedMemory, std::unique_ptr<ISharedMemory>&& txSharedMemory)
-		: m_rxSharedMemoryPipe {std::move(rxSharedMemory)}
-		, m_txSharedMemoryPipe {std::move(txSharedMemory)}
+	SharedMemoryPipe(std::unique_ptr<ISharedMemory>&& rxSharedMemory, std::unique_ptr<ISharedMemory>&& txSharedMemory, const RingBufferOptions& options = {})
+		: m_rxSharedMemoryPipe {std::move(rxSharedMemory), options}
+		, m_txSharedMemoryPipe {std::move(txSharedMemory), options}
 	{}
 
 	~SharedMemoryPipe() = default;
@@ -53,11 +57,63 @@ public:
 		return m_txSharedMemoryPipe;
 	}
 
+	/**
+	 * Get how long this side spent faulting in and locking both segments.
+	 *
+	 * @see SharedMemoryOptions
+	 */
+	[[nodiscard]]
+	auto getWarmUpTime() const -> std::chrono::nanoseconds
+	{
+		return m_rxSharedMemoryPipe.getSharedMemory()->getWarmUpTime() + m_txSharedMemoryPipe.getSharedMemory()->getWarmUpTime();
+	}
+
 	auto read() -> Packet
 	{
 		return m_rxSharedMemoryPipe.read();
 	}
 
+	[[nodiscard]]
+	auto read(std::chrono::nanoseconds timeout) -> std::optional<Packet>
+	{
+		return m_rxSharedMemoryPipe.read(timeout);
+	}
+
+	[[nodiscard]]
+	auto tryRead(Packet& packet) -> RingBufferStatus
+	{
+		return m_rxSharedMemoryPipe.tryRead(packet);
+	}
+
+	[[nodiscard]]
+	auto readMessage(PacketBuffer& message, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) -> bool
+	{
+		return m_rxSharedMemoryPipe.readMessage(message, timeout);
+	}
+
+	[[nodiscard]]
+	auto readMessage(std::span<uint8_t> destination, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) -> std::optional<std::size_t>
+	{
+		return m_rxSharedMemoryPipe.readMessage(destination, timeout);
+	}
+
+	[[nodiscard]]
+	auto peek() const -> PacketView
+	{
+		return m_rxSharedMemoryPipe.peek();
+	}
+
+	void release()
+	{
+		m_rxSharedMemoryPipe.release();
+	}
+
+	template <class Handler>
+	auto drain(Handler&& handler, std::size_t maxPackets = std::numeric_limits<std::size_t>::max()) -> std::size_t
+	{
+		return m_rxSharedMemoryPipe.drain(std::forward<Handler>(handler), maxPackets);
+	}
+
 	void write(Packet&& packet)
 	{
 		m_txSharedMemoryPipe.write(std::move(packet));
@@ -68,29 +124,143 @@ public:
 		m_txSharedMemoryPipe.write(packet);
 	}
 
+	[[nodiscard]]
+	auto write(const Packet& packet, std::chrono::nanoseconds timeout) -> bool
+	{
+		return m_txSharedMemoryPipe.write(packet, timeout);
+	}
+
+	[[nodiscard]]
+	auto tryWrite(const Packet& packet) -> RingBufferStatus
+	{
+		return m_txSharedMemoryPipe.tryWrite(packet);
+	}
+
+	[[nodiscard]]
+	auto writeMessage(std::span<const uint8_t> message, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) -> bool
+	{
+		return m_txSharedMemoryPipe.writeMessage(message, timeout);
+	}
+
+	auto writeBatch(std::span<const Packet> packets) -> std::size_t
+	{
+		return m_txSharedMemoryPipe.writeBatch(packets);
+	}
+
+	auto writeBatch(std::span<const std::span<const uint8_t>> payloads) -> std::size_t
+	{
+		return m_txSharedMemoryPipe.writeBatch(payloads);
+	}
+
+	[[nodiscard]]
+	auto reserve(std::size_t size) -> RingBufferSpan<uint8_t>
+	{
+		return m_txSharedMemoryPipe.reserve(size);
+	}
+
+	void commit()
+	{
+		m_txSharedMemoryPipe.commit();
+	}
+
+	void commit(std::size_t size)
+	{
+		m_txSharedMemoryPipe.commit(size);
+	}
+
+	void cancel() noexcept
+	{
+		m_txSharedMemoryPipe.cancel();
+	}
+
 private:
 	RxSharedMemoryPipe m_rxSharedMemoryPipe;
 	TxSharedMemoryPipe m_txSharedMemoryPipe;
 };
 
-inline std::unique_ptr<SharedMemoryPipe> CreateSharedMemoryPipe(const std::string& name, std::size_t size)
+/**
+ * Create both segments of a pipe. Set `sharedMemoryOptions.mirrored` to map
+ * each ring buffer's data twice so packets never split at the end of the
+ * buffer, the ring buffer header is kept out of the mirror automatically. The
+ * other side picks the layout up from the segments when it opens the pipe.
+ *
+ * Set `sharedMemoryOptions.prefault`, and `lock`, to take the page faults of
+ * both segments up front rather than on the first pass around each ring.
+ *
+ * With `sharedMemoryOptions.backend` set to SharedMemoryBackend::Memfd the
+ * segments are anonymous and nothing is left behind under /dev/shm if either
+ * side crashes. This side then has to stay alive until the other has opened
+ * the pipe, as it hands out the segments itself.
+ *
+ * The ring buffer options apply to this side only. Both sides must agree on
+ * the mode, each one can pick its own wait strategy.
+ */
+inline std::unique_ptr<SharedMemoryPipe> CreateSharedMemoryPipe(const std::string& name, std::size_t size, SharedMemoryOptions sharedMemoryOptions = {}, const RingBufferOptions& ringBufferOptions = {})
+{
+	sharedMemoryOptions.mirrorOffset = sizeof(RingBuffer::RingBufferHeader);
+
+	auto rxSharedMemory = MakeUniqueSharedMemory(sharedMemoryOptions.backend);
+	auto txSharedMemory = MakeUniqueSharedMemory(sharedMemoryOptions.backend);
+	rxSharedMemory->create("/smipc." + name + ".rx", size, sharedMemoryOptions);
+	txSharedMemory->create("/smipc." + name + ".tx", size, sharedMemoryOptions);
+
+	return std::make_unique<SharedMemoryPipe>(std::move(rxSharedMemory), std::move(txSharedMemory), ringBufferOptions);
+}
+
+/**
+ * Open both segments of a pipe created by the other side. The layout comes from
+ * the segments, the shared memory options only say how this side's mappings
+ * are warmed up.
+ */
+inline std::unique_ptr<SharedMemoryPipe> OpenSharedMemoryPipe(const std::string& name, const RingBufferOptions& ringBufferOptions = {}, const SharedMemoryOpenOptions& sharedMemoryOptions = {})
 {
-	auto rxSharedMemory = MakeUniqueSharedMemory();
-	auto txSharedMemory = MakeUniqueSharedMemory();
-	rxSharedMemory->create("/smipc." + name + ".rx", size);
-	txSharedMemory->create("/smipc." + name + ".tx", size);
+	auto rxSharedMemory = MakeUniqueSharedMemory(sharedMemoryOptions.backend);
+	auto txSharedMemory = MakeUniqueSharedMemory(sharedMemoryOptions.backend);
+	rxSharedMemory->open("/smipc." + name + ".tx", sharedMemoryOptions);
+	txSharedMemory->open("/smipc." + name + ".rx", sharedMemoryOptions);
+
+	return std::make_unique<SharedMemoryPipe>(std::move(rxSharedMemory), std::move(txSharedMemory), ringBufferOptions);
+}
 
-	return std::make_unique<SharedMemoryPipe>(std::move(rxSharedMemory), std::move(txSharedMemory));
+/**
+ * Read the statistics of the ring buffer in a shared memory segment.
+ *
+ * Only the counters are read, so a monitoring process can poll a segment
+ * while the pipe using it is busy. A pipe carries the host's packets in
+ * "/smipc.<name>.tx" and the client's in "/smipc.<name>.rx". A monitor should
+ * open the segment with `readOnly` set, a normal open would tear the pipe
+ * down on close.
+ *
+ * @throws std::invalid_argument if the segment does not hold a ring buffer.
+ */
+inline auto ReadRingBufferStatistics(const SharedMemoryView& view) -> RingBufferStatistics
+{
+	return RingBuffer::ReadStatistics({reinterpret_cast<const uint8_t*>(view.data), static_cast<std::size_t>(*view.dataSize)});
 }
 
-inline std::unique_ptr<SharedMemoryPipe> OpenSharedMemoryPipe(const std::string& name)
+/**
+ * Open a segment read-only, read the statistics of its ring buffer and close
+ * it again, leaving the pipe using it untouched.
+ *
+ * @throws std::runtime_error if the segment cannot be opened.
+ * @throws std::invalid_argument if the segment does not hold a ring buffer.
+ */
+inline auto ReadRingBufferStatistics(const std::string& segmentName, SharedMemoryBackend backend = SharedMemoryBackend::Named) -> RingBufferStatistics
 {
-	auto rxSharedMemory = MakeUniqueSharedMemory();
-	auto txSharedMemory = MakeUniqueSharedMemory();
-	rxSharedMemory->open("/smipc." + name + ".tx");
-	txSharedMemory->open("/smipc." + name + ".rx");
+	auto sharedMemory = MakeUniqueSharedMemory(backend);
+	sharedMemory->open(segmentName, {.backend = backend, .readOnly = true});
 
-	return std::make_unique<SharedMemoryPipe>(std::move(rxSharedMemory), std::move(txSharedMemory));
+	try
+	{
+		const RingBufferStatistics statistics {ReadRingBufferStatistics(sharedMemory->getView())};
+		sharedMemory->close();
+		return statistics;
+	}
+	catch (...)
+	{
+		sharedMemory->close();
+		throw;
+	}
 }
 
 #endif  // SHARED_MEMORY_PIPE_H_
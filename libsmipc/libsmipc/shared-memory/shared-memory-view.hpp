@@ -33,19 +33,36 @@ enum class Signal : uint32_t
 	Close,
 };
 
+enum class SharedMemoryFlag : uint32_t
+{
+	// The data region from the mirror start on is mapped twice, back to back
+	Mirrored,
+};
+
 struct SharedMemoryView
 {
 	std::atomic_flag* lock {nullptr};
 	uint32_t* refCount {0u};
 	std::bitset<32u>* signals {0u};
-	uint32_t* dataSize {nullptr};
+	uint64_t* dataSize {nullptr};
+	std::bitset<32u>* flags {nullptr};
+	uint32_t* dataOffset {nullptr};
+	// Offset of the page the mirrored part starts on, zero unless mirrored
+	uint32_t* mirrorStart {nullptr};
 	std::byte* data {nullptr};
 };
 
 constexpr std::size_t kSharedMemoryViewLockOffset {0u};
 constexpr std::size_t kSharedMemoryViewRefCountOffset {kSharedMemoryViewLockOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::lock)>)};
 constexpr std::size_t kSharedMemoryViewSignalsOffset {kSharedMemoryViewRefCountOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::refCount)>)};
-constexpr std::size_t kSharedMemoryViewDataSizeOffset {kSharedMemoryViewSignalsOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::signals)>)};
-constexpr std::size_t kSharedMemoryViewDataOffset {kSharedMemoryViewDataSizeOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::dataSize)>)};
+// Rounded up so the 64-bit size is naturally aligned
+constexpr std::size_t kSharedMemoryViewDataSizeOffset {(kSharedMemoryViewSignalsOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::signals)>) + alignof(uint64_t) - 1u) / alignof(uint64_t) * alignof(uint64_t)};
+constexpr std::size_t kSharedMemoryViewFlagsOffset {kSharedMemoryViewDataSizeOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::dataSize)>)};
+constexpr std::size_t kSharedMemoryViewDataOffsetOffset {kSharedMemoryViewFlagsOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::flags)>)};
+constexpr std::size_t kSharedMemoryViewMirrorStartOffset {kSharedMemoryViewDataOffsetOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::dataOffset)>)};
+
+// The data region starts on its own cache line so ring buffers placed in it keep their alignment
+constexpr std::size_t kSharedMemoryViewDataAlignment {64u};
+constexpr std::size_t kSharedMemoryViewDataOffset {(kSharedMemoryViewMirrorStartOffset + sizeof(std::remove_pointer_t<decltype(SharedMemoryView::mirrorStart)>) + kSharedMemoryViewDataAlignment - 1u) / kSharedMemoryViewDataAlignment * kSharedMemoryViewDataAlignment};
 
 #endif  // SHARED_MEMORY_VIEW_HPP_
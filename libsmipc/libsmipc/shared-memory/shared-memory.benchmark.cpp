@@ -0,0 +1,557 @@
+/* MIT License
+ * 
+ * Copyright (c) 2024 Josef de Joanelli (josef@pixelrift.io)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <libsmipc/shared-memory/shared-memory-pipe.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#	include <sched.h>
+#	include <signal.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+
+// Segments are big enough that the largest payload fits in one go
+static constexpr std::size_t kPingPongSegmentSize {4u * 1024u * 1024u};
+// How long the host waits on the peer before deciding it is gone
+static constexpr std::chrono::seconds kPeerTimeout {5};
+
+// Cores to pin the benchmark and its peer process to, -1 leaves them to the scheduler
+static int s_hostCore {-1};
+static int s_peerCore {-1};
+
+static auto PinToCore(int core) -> bool
+{
+	if (core < 0)
+	{
+		return true;
+	}
+
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core, &cpuSet);
+
+	return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+}
+
+/**
+ * Pin the calling thread to a core for the lifetime of the object, then put
+ * its previous affinity back so the benchmarks that run after it are not
+ * left on one core.
+ */
+class ScopedCorePin
+{
+public:
+	explicit ScopedCorePin(int core)
+	{
+		m_saved = core >= 0 && sched_getaffinity(0, sizeof(m_previous), &m_previous) == 0;
+		m_pinned = (core < 0 || m_saved) && PinToCore(core);
+	}
+
+	ScopedCorePin(const ScopedCorePin&) = delete;
+	auto operator=(const ScopedCorePin&) -> ScopedCorePin& = delete;
+
+	~ScopedCorePin()
+	{
+		if (m_saved)
+		{
+			static_cast<void>(sched_setaffinity(0, sizeof(m_previous), &m_previous));
+		}
+	}
+
+	[[nodiscard]]
+	auto isPinned() const noexcept -> bool
+	{
+		return m_pinned;
+	}
+
+private:
+	cpu_set_t m_previous {};
+	bool m_saved {false};
+	bool m_pinned {false};
+};
+
+/**
+ * Reap the peer process, killing it first when the host has given up on it.
+ *
+ * @return Whether the peer exited successfully.
+ */
+[[nodiscard]]
+static auto WaitForPeer(pid_t peer, bool abandoned) -> bool
+{
+	if (abandoned)
+	{
+		kill(peer, SIGKILL);
+	}
+
+	int status {};
+	waitpid(peer, &status, 0);
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/**
+ * Echo every message back until one of a different size arrives.
+ */
+static void RunEchoPeer(const std::string& name, std::size_t payloadSize)
+{
+	const auto pipe = OpenSharedMemoryPipe(name);
+	PacketBuffer message;
+
+	while (pipe->readMessage(message) && message.size() == payloadSize)
+	{
+		static_cast<void>(pipe->writeMessage(message));
+	}
+}
+
+[[nodiscard]]
+static auto GetPercentile(const std::vector<double>& sorted, double percentile) -> double
+{
+	const auto rank {static_cast<std::size_t>(percentile / 100.0 * static_cast<double>(sorted.size() - 1u) + 0.5)};
+	return sorted[std::min(rank, sorted.size() - 1u)];
+}
+
+/**
+ * Round trips between this process and a forked peer through a shared memory
+ * pipe, so every message crosses two address spaces and, when pinned, two
+ * cores. The reported time is the mean round trip, the percentiles of every
+ * round trip in the run are added as counters in nanoseconds.
+ */
+static void BM_ping_pong(benchmark::State& state)
+{
+	const auto payloadSize {static_cast<std::size_t>(state.range(0))};
+	const std::string name {"benchmark-ping-pong"};
+	const auto hostPipe = CreateSharedMemoryPipe(name, kPingPongSegmentSize);
+
+	const pid_t peer {fork()};
+
+	if (peer == -1)
+	{
+		state.SkipWithError("Failed to fork the peer process");
+		return;
+	}
+
+	if (peer == 0)
+	{
+		// The peer leaves with _exit, the pipes are the host's to clean up
+		int status {EXIT_SUCCESS};
+
+		try
+		{
+			if (! PinToCore(s_peerCore))
+			{
+				_exit(EXIT_FAILURE);
+			}
+
+			RunEchoPeer(name, payloadSize);
+		}
+		catch (...)
+		{
+			status = EXIT_FAILURE;
+		}
+
+		_exit(status);
+	}
+
+	const ScopedCorePin pin {s_hostCore};
+
+	if (! pin.isPinned())
+	{
+		state.SkipWithError("Failed to pin the benchmark to its core");
+	}
+
+	const std::vector<uint8_t> payload(payloadSize, 0x5Au);
+	PacketBuffer reply;
+	std::vector<double> roundTrips;
+	roundTrips.reserve(static_cast<std::size_t>(state.max_iterations));
+
+	// A peer that died early never answers, so every wait on it is bounded
+	bool abandoned {false};
+
+	for (auto _ : state)
+	{
+		const auto start {std::chrono::steady_clock::now()};
+
+		if (! hostPipe->writeMessage(payload, kPeerTimeout) || ! hostPipe->readMessage(reply, kPeerTimeout) || reply.size() != payloadSize)
+		{
+			state.SkipWithError("Peer did not echo the message");
+			abandoned = true;
+			break;
+		}
+
+		const std::chrono::duration<double> roundTrip {std::chrono::steady_clock::now() - start};
+		state.SetIterationTime(roundTrip.count());
+		roundTrips.push_back(roundTrip.count() * 1e9);
+	}
+
+	// Any message of another size stops the peer
+	abandoned = abandoned || ! hostPipe->writeMessage(std::vector<uint8_t>(1u), kPeerTimeout);
+
+	if (! WaitForPeer(peer, abandoned) || abandoned)
+	{
+		if (! state.error_occurred())
+		{
+			state.SkipWithError("Peer process failed");
+		}
+
+		return;
+	}
+
+	if (! roundTrips.empty())
+	{
+		std::sort(roundTrips.begin(), roundTrips.end());
+		state.counters["p50_ns"] = GetPercentile(roundTrips, 50.0);
+		state.counters["p99_ns"] = GetPercentile(roundTrips, 99.0);
+		state.counters["p99.9_ns"] = GetPercentile(roundTrips, 99.9);
+		state.counters["max_ns"] = roundTrips.back();
+	}
+
+	state.SetBytesProcessed(state.iterations() * state.range(0) * 2);
+}
+
+BENCHMARK(BM_ping_pong)->RangeMultiplier(8)->Range(8, 1024 * 1024)->UseManualTime();
+
+/**
+ * Read messages until one of a different size arrives, then acknowledge it.
+ */
+static void RunSinkPeer(const std::string& name, std::size_t payloadSize, const RingBufferOptions& options)
+{
+	const auto pipe = OpenSharedMemoryPipe(name, options);
+	PacketBuffer message;
+
+	while (pipe->readMessage(message) && message.size() == payloadSize)
+	{
+	}
+
+	static_cast<void>(pipe->writeMessage(message));
+}
+
+/**
+ * A one way stream of small messages to a forked peer through a Locked pipe,
+ * so both processes take the ring's lock for every message, under each lock
+ * policy. The ring is kept small so the two sides meet on the lock instead of
+ * running on opposite ends of a mostly empty buffer.
+ */
+static void BM_lock_policy_processes(benchmark::State& state, LockPolicy policy)
+{
+	constexpr std::size_t kPayloadSize {64u};
+	const std::string name {"benchmark-lock-policy"};
+	const RingBufferOptions options {.mode = RingBufferMode::Locked, .lockPolicy = policy};
+	const auto hostPipe = CreateSharedMemoryPipe(name, RingBuffer::GetMemoryBlockSize(4u * 1024u), {}, options);
+
+	const pid_t peer {fork()};
+
+	if (peer == -1)
+	{
+		state.SkipWithError("Failed to fork the peer process");
+		return;
+	}
+
+	if (peer == 0)
+	{
+		int status {EXIT_SUCCESS};
+
+		try
+		{
+			if (! PinToCore(s_peerCore))
+			{
+				_exit(EXIT_FAILURE);
+			}
+
+			RunSinkPeer(name, kPayloadSize, options);
+		}
+		catch (...)
+		{
+			status = EXIT_FAILURE;
+		}
+
+		_exit(status);
+	}
+
+	const ScopedCorePin pin {s_hostCore};
+
+	if (! pin.isPinned())
+	{
+		state.SkipWithError("Failed to pin the benchmark to its core");
+	}
+
+	const std::vector<uint8_t> payload(kPayloadSize, 0x5Au);
+	bool abandoned {false};
+
+	for (auto _ : state)
+	{
+		if (! hostPipe->writeMessage(payload, kPeerTimeout))
+		{
+			state.SkipWithError("Peer stopped reading");
+			abandoned = true;
+			break;
+		}
+	}
+
+	// Wait for the peer to read everything, so the time covers both sides
+	PacketBuffer reply;
+	abandoned = abandoned || ! hostPipe->writeMessage(std::vector<uint8_t>(1u), kPeerTimeout) || ! hostPipe->readMessage(reply, kPeerTimeout);
+
+	if (! WaitForPeer(peer, abandoned) || abandoned)
+	{
+		if (! state.error_occurred())
+		{
+			state.SkipWithError("Peer process failed");
+		}
+
+		return;
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_lock_policy_processes, dekker, LockPolicy::Dekker)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lock_policy_processes, ttas, LockPolicy::TestAndTestAndSet)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lock_policy_processes, ticket, LockPolicy::Ticket)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lock_policy_processes, robust_mutex, LockPolicy::RobustMutex)->UseRealTime();
+
+/**
+ * A producer thread streaming 16KB messages through a ring of the given size in
+ * a shared memory segment created with the given options. The page size and
+ * NUMA node the segment actually got are reported, as both are best effort.
+ */
+static void StreamThroughSegment(benchmark::State& state, std::size_t capacity, const SharedMemoryOptions& options)
+{
+	constexpr std::size_t kMessageSize {16u * 1024u};
+
+	auto sharedMemory = MakeUniqueSharedMemory();
+	sharedMemory->create("/smipc.stream-benchmark", kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(capacity), options);
+
+	auto* memory = reinterpret_cast<uint8_t*>(sharedMemory->getView().data);
+	const auto size {static_cast<std::size_t>(*sharedMemory->getView().dataSize)};
+	TxRingBuffer tx(memory, size, RingBufferMode::LockFree);
+	RxRingBuffer rx(memory, size, RingBufferMode::LockFree);
+
+	const Packet packet {std::vector<uint8_t>(kMessageSize, 0x5Au)};
+	const auto packetCount {state.max_iterations};
+
+	// Only a full ring is worth retrying, anything else would never go through
+	std::atomic<RingBufferStatus> producerStatus {RingBufferStatus::Ok};
+	std::atomic_bool consumerStopped {false};
+
+	std::thread producer([&tx, &packet, &producerStatus, &consumerStopped, packetCount]()
+		{
+			for (benchmark::IterationCount i = 0; i < packetCount; ++i)
+			{
+				RingBufferStatus status {};
+
+				while ((status = tx.tryPush(packet)) == RingBufferStatus::Full)
+				{
+					if (consumerStopped.load(std::memory_order_relaxed))
+					{
+						return;
+					}
+
+					std::this_thread::yield();
+				}
+
+				if (status != RingBufferStatus::Ok)
+				{
+					producerStatus.store(status, std::memory_order_release);
+					return;
+				}
+			}
+		});
+
+	Packet received;
+
+	for (auto _ : state)
+	{
+		RingBufferStatus status {};
+
+		while ((status = rx.tryPull(received)) == RingBufferStatus::Empty && producerStatus.load(std::memory_order_acquire) == RingBufferStatus::Ok)
+		{
+			std::this_thread::yield();
+		}
+
+		if (status != RingBufferStatus::Ok)
+		{
+			state.SkipWithError(status == RingBufferStatus::Empty ? "The producer failed to push" : "The consumer failed to pull");
+			break;
+		}
+
+		benchmark::DoNotOptimize(received.data.data());
+	}
+
+	consumerStopped.store(true, std::memory_order_relaxed);
+	producer.join();
+
+	state.counters["page_size"] = static_cast<double>(sharedMemory->getPageSize());
+	state.counters["numa_node"] = static_cast<double>(sharedMemory->getNumaNode());
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(kMessageSize));
+	sharedMemory->close();
+}
+
+/**
+ * Streaming with and without huge pages behind the ring. Rings larger than the
+ * TLB covers are where huge pages pay. Without a hugetlbfs pool to take from
+ * the segment falls back to normal pages.
+ */
+static void BM_stream_huge_pages(benchmark::State& state, std::size_t hugePageSize)
+{
+	StreamThroughSegment(state, static_cast<std::size_t>(state.range(0)), {.hugePageSize = hugePageSize});
+}
+
+BENCHMARK_CAPTURE(BM_stream_huge_pages, normal, 0u)->Arg(16 * 1024 * 1024)->Arg(256 * 1024 * 1024)->UseRealTime();
+BENCHMARK_CAPTURE(BM_stream_huge_pages, huge_2m, kHugePageSize2M)->Arg(16 * 1024 * 1024)->Arg(256 * 1024 * 1024)->UseRealTime();
+BENCHMARK_CAPTURE(BM_stream_huge_pages, huge_1g, kHugePageSize1G)->Arg(256 * 1024 * 1024)->UseRealTime();
+
+/**
+ * Streaming through a ring placed on a given NUMA node. Pinning the benchmark
+ * to the other node, with numactl --cpunodebind, shows the cost of a remote
+ * ring. On a single node machine every policy places the pages alike.
+ */
+static void BM_stream_numa(benchmark::State& state, NumaPolicy policy, uint32_t node)
+{
+	StreamThroughSegment(state, 64u * 1024u * 1024u, {.prefault = true, .numaPolicy = policy, .numaNode = node});
+}
+
+BENCHMARK_CAPTURE(BM_stream_numa, first_touch, NumaPolicy::FirstTouch, 0u)->UseRealTime();
+BENCHMARK_CAPTURE(BM_stream_numa, node_0, NumaPolicy::Bind, 0u)->UseRealTime();
+BENCHMARK_CAPTURE(BM_stream_numa, node_1, NumaPolicy::Bind, 1u)->UseRealTime();
+BENCHMARK_CAPTURE(BM_stream_numa, interleave, NumaPolicy::Interleave, 0u)->UseRealTime();
+
+/**
+ * Setting a pipe up and tearing it down again, with segments looked up by name
+ * or handed over as descriptors.
+ */
+static void BM_pipe_connect(benchmark::State& state, SharedMemoryBackend backend)
+{
+	for (auto _ : state)
+	{
+		const auto hostPipe = CreateSharedMemoryPipe("connect-benchmark", 64u * 1024u, {.backend = backend});
+		const auto clientPipe = OpenSharedMemoryPipe("connect-benchmark", {}, {.backend = backend});
+		benchmark::DoNotOptimize(clientPipe.get());
+	}
+}
+
+BENCHMARK_CAPTURE(BM_pipe_connect, named, SharedMemoryBackend::Named)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_pipe_connect, memfd, SharedMemoryBackend::Memfd)->Unit(benchmark::kMicrosecond);
+
+/**
+ * The first pass around a freshly created ring, where every page the packets
+ * land on faults in, with and without prefaulting the segment. The warm-up is
+ * left out of the timing and reported as a counter instead.
+ */
+static void BM_first_pass(benchmark::State& state, bool prefault)
+{
+	constexpr std::size_t kCapacity {16u * 1024u * 1024u};
+	constexpr std::size_t kMessageSize {64u * 1024u};
+
+	const Packet packet {std::vector<uint8_t>(kMessageSize, 0x5Au)};
+	Packet received;
+	std::chrono::nanoseconds warmUpTime {};
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto sharedMemory = MakeUniqueSharedMemory();
+		sharedMemory->create("/smipc.first-pass-benchmark", kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(kCapacity), {.prefault = prefault});
+		warmUpTime += sharedMemory->getWarmUpTime();
+
+		auto* memory = reinterpret_cast<uint8_t*>(sharedMemory->getView().data);
+		const auto size {static_cast<std::size_t>(*sharedMemory->getView().dataSize)};
+		TxRingBuffer tx(memory, size, RingBufferMode::LockFree);
+		RxRingBuffer rx(memory, size, RingBufferMode::LockFree);
+		state.ResumeTiming();
+
+		for (std::size_t written = 0u; written < kCapacity; written += kMessageSize)
+		{
+			tx.push(packet);
+			benchmark::DoNotOptimize(rx.tryPull(received));
+		}
+
+		state.PauseTiming();
+		sharedMemory->close();
+		state.ResumeTiming();
+	}
+
+	state.counters["warm_up_us"] = benchmark::Counter(static_cast<double>(warmUpTime.count()) / 1000.0, benchmark::Counter::kAvgIterations);
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(kCapacity));
+}
+
+BENCHMARK_CAPTURE(BM_first_pass, lazy, false)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_first_pass, prefault, true)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+/**
+ * Take --host_core=N and --peer_core=N out of the arguments, Google Benchmark
+ * rejects flags it does not know.
+ */
+static void ParseCoreFlags(int& argc, char** argv)
+{
+	int kept {1};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument {argv[i]};
+
+		if (argument.starts_with("--host_core="))
+		{
+			s_hostCore = std::atoi(argv[i] + std::string_view {"--host_core="}.size());
+		}
+		else if (argument.starts_with("--peer_core="))
+		{
+			s_peerCore = std::atoi(argv[i] + std::string_view {"--peer_core="}.size());
+		}
+		else
+		{
+			argv[kept++] = argv[i];
+		}
+	}
+
+	argc = kept;
+}
+#else
+static void ParseCoreFlags(int&, char**)
+{}
+#endif
+
+int main(int argc, char** argv)
+{
+	ParseCoreFlags(argc, argv);
+	benchmark::Initialize(&argc, argv);
+
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 1;
+	}
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -25,11 +25,26 @@
 
 #include <gtest/gtest.h>
 
+#ifdef __linux__
+#	include <fcntl.h>
+#	include <linux/capability.h>
+#	include <sys/mman.h>
+#	include <sys/resource.h>
+#	include <sys/syscall.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <numeric>
+#include <thread>
 
 TEST(shared_memory_pipe, host_creation)
 {
-	constexpr std::size_t kSharedMemorySize {256u};
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
 	constexpr std::size_t bufferSize {kSharedMemorySize - kSharedMemoryViewDataOffset};
 	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
 
@@ -61,7 +76,7 @@ TEST(shared_memory_pipe, host_creation)
 
 TEST(shared_memory_pipe, client_creation)
 {
-	constexpr std::size_t kSharedMemorySize {256u};
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
 	constexpr std::size_t bufferSize {kSharedMemorySize - kSharedMemoryViewDataOffset};
 	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
 	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
@@ -94,7 +109,7 @@ TEST(shared_memory_pipe, client_creation)
 
 TEST(shared_memory_pipe, basic_rx_tx)
 {
-	constexpr std::size_t kSharedMemorySize {256u};
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
 	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
 	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
 
@@ -123,6 +138,455 @@ TEST(shared_memory_pipe, basic_rx_tx)
 	EXPECT_EQ(rxPacket.data, packet.data);
 }
 
+TEST(shared_memory_pipe, reserve_commit)
+{
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+	const std::vector<uint8_t> payload {1u, 2u, 3u, 4u, 5u};
+	auto region = hostPipe->reserve(payload.size());
+	ASSERT_TRUE(region.isContiguous());
+	std::copy(payload.begin(), payload.end(), region.first.begin());
+	hostPipe->commit();
+
+	const auto rxPacket = clientPipe->read();
+	EXPECT_EQ(rxPacket.data, payload);
+}
+
+TEST(shared_memory_pipe, peek_release)
+{
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+	const Packet packet {std::vector<uint8_t>({1u, 2u, 3u, 4u, 5u})};
+	hostPipe->write(packet);
+
+	const auto view = clientPipe->peek();
+	ASSERT_TRUE(view.data.isContiguous());
+	EXPECT_EQ(std::vector<uint8_t>(view.data.first.begin(), view.data.first.end()), packet.data);
+
+	clientPipe->release();
+	EXPECT_EQ(clientPipe->getRxPipe().getRingBuffer().getMessageCount(), 0u);
+}
+
+TEST(shared_memory_pipe, drain)
+{
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+	hostPipe->write(Packet {std::vector<uint8_t>({1u})});
+	hostPipe->write(Packet {std::vector<uint8_t>({2u})});
+
+	std::vector<uint8_t> rxData;
+	EXPECT_EQ(clientPipe->drain([&rxData](const PacketView& view) { rxData.push_back(view.data.first.front()); }), 2u);
+	EXPECT_EQ(rxData, std::vector<uint8_t>({1u, 2u}));
+}
+
+TEST(shared_memory_pipe, try_read_write)
+{
+	constexpr std::size_t kSharedMemorySize {kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(192u)};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+	Packet rxPacket;
+	EXPECT_EQ(clientPipe->tryRead(rxPacket), RingBufferStatus::Empty);
+
+	const Packet packet {std::vector<uint8_t>({1u, 2u, 3u, 4u, 5u})};
+	EXPECT_EQ(hostPipe->tryWrite(packet), RingBufferStatus::Ok);
+	EXPECT_EQ(hostPipe->tryWrite(Packet {std::vector<uint8_t>(kSharedMemorySize)}), RingBufferStatus::TooLarge);
+
+	EXPECT_EQ(clientPipe->tryRead(rxPacket), RingBufferStatus::Ok);
+	EXPECT_EQ(rxPacket.data, packet.data);
+}
+
+TEST(shared_memory_pipe, message_fragmentation)
+{
+	constexpr std::size_t kSharedMemorySize {64u * 1024u};
+	constexpr std::size_t kMessageSize {1024u * 1024u + 3u};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+	std::vector<uint8_t> message(kMessageSize);
+	std::iota(message.begin(), message.end(), uint8_t {7u});
+	ASSERT_GT(message.size(), 16u * hostPipe->getTxPipe().getFragmentSize());
+
+	// The message is many times the ring size, so writer and reader have to overlap
+	std::thread writer([&hostPipe, &message]()
+		{
+			EXPECT_TRUE(hostPipe->writeMessage(message));
+			EXPECT_TRUE(hostPipe->writeMessage(std::span<const uint8_t>(message).first(100u)));
+		});
+
+	PacketBuffer received;
+	ASSERT_TRUE(clientPipe->readMessage(received));
+	EXPECT_EQ(received, message);
+
+	// Messages that fit in one fragment come through too, as do plain packets
+	std::array<uint8_t, 128u> destination {};
+	EXPECT_EQ(clientPipe->readMessage(destination), 100u);
+	EXPECT_TRUE(std::equal(message.begin(), message.begin() + 100, destination.begin()));
+	writer.join();
+
+	hostPipe->write(Packet {std::vector<uint8_t>({1u, 2u, 3u})});
+	EXPECT_EQ(clientPipe->readMessage(destination, std::chrono::milliseconds {10}), 3u);
+	EXPECT_EQ(clientPipe->readMessage(destination, std::chrono::milliseconds {1}), std::nullopt);
+
+	// A message too big for the destination is dropped without upsetting the next one
+	ASSERT_TRUE(hostPipe->writeMessage(std::span<const uint8_t>(message).first(2u * hostPipe->getTxPipe().getFragmentSize())));
+	ASSERT_TRUE(hostPipe->writeMessage(std::span<const uint8_t>(message).first(10u)));
+	EXPECT_THROW((void)clientPipe->readMessage(destination), std::length_error);
+	EXPECT_EQ(clientPipe->readMessage(destination), 10u);
+	EXPECT_TRUE(clientPipe->getRxPipe().getRingBuffer().isEmpty());
+}
+
+TEST(shared_memory_pipe, message_checksum)
+{
+	constexpr RingBufferOptions options {.checksum = true};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(4096u), {}, options);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe", options);
+
+	std::vector<uint8_t> message(3u * hostPipe->getTxPipe().getFragmentSize() + 5u);
+	std::iota(message.begin(), message.end(), uint8_t {3u});
+
+	ASSERT_TRUE(hostPipe->writeMessage(message));
+	PacketBuffer received;
+	ASSERT_TRUE(clientPipe->readMessage(received));
+	EXPECT_EQ(received, message);
+
+	// A corrupted fragment drops the rest of its message
+	ASSERT_TRUE(hostPipe->writeMessage(message));
+	const PacketView view {clientPipe->getRxPipe().getRingBuffer().peek()};
+	const_cast<uint8_t&>(view.data.first.back()) ^= 0x80u;
+
+	EXPECT_THROW((void)clientPipe->readMessage(received), std::runtime_error);
+	EXPECT_EQ(clientPipe->getRxPipe().getRingBuffer().getChecksumMismatchCount(), 1u);
+
+	ASSERT_TRUE(hostPipe->writeMessage(std::span<const uint8_t>(message).first(10u)));
+	ASSERT_TRUE(clientPipe->readMessage(received));
+	EXPECT_EQ(received, std::span<const uint8_t>(message).first(10u));
+}
+
+TEST(shared_memory_pipe, statistics)
+{
+	constexpr RingBufferOptions options {.statistics = true};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(1024u), {}, options);
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe", options);
+
+	hostPipe->write(Packet {std::vector<uint8_t>(100u)});
+	static_cast<void>(clientPipe->read());
+
+	// A monitor reads the counters straight from the segment, without holding a reference to it
+	auto monitor = MakeUniqueSharedMemory();
+	monitor->open("/smipc.test-pipe.tx", {.readOnly = true});
+	EXPECT_EQ(*monitor->getView().refCount, 2u);
+	const RingBufferStatistics statistics {ReadRingBufferStatistics(monitor->getView())};
+	monitor->close();
+
+	EXPECT_EQ(statistics.pushedPackets, 1u);
+	EXPECT_EQ(statistics.pushedBytes, 100u);
+	EXPECT_EQ(statistics.pulledBytes, 100u);
+	EXPECT_EQ(statistics.capacity, clientPipe->getRxPipe().getRingBuffer().getCapacity());
+	EXPECT_EQ(ReadRingBufferStatistics(hostPipe->getRxPipe().getSharedMemory()->getView()).pushedPackets, 0u);
+	EXPECT_EQ(ReadRingBufferStatistics("/smipc.test-pipe.rx").pushedPackets, 0u);
+
+	// Closing the monitors left the pipe in place, another client can still reach it
+	EXPECT_EQ(*hostPipe->getTxPipe().getSharedMemory()->getView().refCount, 2u);
+	const auto otherClient = OpenSharedMemoryPipe("test-pipe", options);
+	hostPipe->write(Packet {std::vector<uint8_t>(10u)});
+	EXPECT_EQ(otherClient->read().data.size(), 10u);
+}
+
+#ifdef __linux__
+TEST(shared_memory_pipe, mirrored)
+{
+	const std::size_t pageSize {static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(pageSize), {.mirrored = true});
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+	const auto* sharedMemory = clientPipe->getRxPipe().getSharedMemory();
+	ASSERT_TRUE(sharedMemory->isMirrored());
+	ASSERT_TRUE(hostPipe->getTxPipe().getSharedMemory()->isMirrored());
+	EXPECT_TRUE(clientPipe->getRxPipe().getRingBuffer().isMirrored());
+
+	// The ring buffer data starts on a page boundary and reappears directly after itself
+	const auto capacity = clientPipe->getRxPipe().getRingBuffer().getCapacity();
+	auto* ringData = sharedMemory->getView().data + sizeof(RingBuffer::RingBufferHeader);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(ringData) % pageSize, 0u);
+	EXPECT_EQ(sharedMemory->getSize() - capacity, *sharedMemory->getView().mirrorStart);
+	EXPECT_EQ(std::to_integer<uint32_t>(ringData[capacity]), 0u);
+	ringData[0] = std::byte {0xAB};
+	EXPECT_EQ(std::to_integer<uint32_t>(ringData[capacity]), 0xABu);
+	ringData[0] = std::byte {0u};
+
+	// Odd sized packets walk the cursors across the end of the buffer several times
+	for (uint8_t i = 0u; i < 20u; ++i)
+	{
+		std::vector<uint8_t> payload(1000u);
+		std::iota(payload.begin(), payload.end(), i);
+		hostPipe->write(Packet {payload});
+
+		const auto view = clientPipe->peek();
+		ASSERT_TRUE(view.data.isContiguous());
+		EXPECT_EQ(std::vector<uint8_t>(view.data.first.begin(), view.data.first.end()), payload);
+		clientPipe->release();
+	}
+}
+
+TEST(shared_memory_pipe, huge_pages)
+{
+	const std::size_t pageSize {static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+
+	for (const bool mirrored : {false, true})
+	{
+		const auto hostPipe = CreateSharedMemoryPipe("test-pipe", 3u * 1024u * 1024u, {.mirrored = mirrored, .hugePageSize = kHugePageSize2M});
+		const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+		// Without a hugetlbfs mount with free 2 MB pages the segments fall back to normal pages
+		const auto* hostMemory = hostPipe->getTxPipe().getSharedMemory();
+		const auto* clientMemory = clientPipe->getRxPipe().getSharedMemory();
+		const std::size_t segmentPageSize {hostMemory->getPageSize()};
+
+		EXPECT_TRUE(segmentPageSize == kHugePageSize2M || segmentPageSize == pageSize);
+		EXPECT_EQ(clientMemory->getPageSize(), segmentPageSize);
+		EXPECT_EQ(clientMemory->getSize(), hostMemory->getSize());
+		EXPECT_EQ(clientMemory->isMirrored(), mirrored);
+
+		if (segmentPageSize != pageSize)
+		{
+			EXPECT_EQ(hostMemory->getSize() % segmentPageSize, 0u);
+		}
+
+		std::vector<uint8_t> message(1024u * 1024u);
+		std::iota(message.begin(), message.end(), static_cast<uint8_t>(mirrored));
+
+		for (uint32_t i = 0u; i < 4u; ++i)
+		{
+			ASSERT_TRUE(hostPipe->writeMessage(message));
+
+			PacketBuffer received;
+			ASSERT_TRUE(clientPipe->readMessage(received));
+			EXPECT_TRUE(std::equal(message.begin(), message.end(), received.data(), received.data() + received.size()));
+		}
+	}
+}
+
+/**
+ * Count the pages of a segment's mapping that are resident.
+ */
+static auto CountResidentPages(const ISharedMemory& sharedMemory) -> std::size_t
+{
+	const std::size_t pageSize {static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+	const std::size_t size {sharedMemory.getSize()};
+	std::vector<unsigned char> residency((size + pageSize - 1u) / pageSize);
+
+	if (mincore(sharedMemory.getView().lock, size, residency.data()) == -1)
+	{
+		return 0u;
+	}
+
+	return static_cast<std::size_t>(std::count_if(residency.begin(), residency.end(), [](unsigned char page) { return (page & 1u) != 0u; }));
+}
+
+TEST(shared_memory_pipe, prefault)
+{
+	constexpr std::size_t kSharedMemorySize {4u * 1024u * 1024u};
+	const std::size_t pageCount {kSharedMemorySize / static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+
+	for (const bool mirrored : {false, true})
+	{
+		// Lazily faulted segments have only their headers resident
+		{
+			const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, {.mirrored = mirrored});
+			const auto* hostMemory = hostPipe->getTxPipe().getSharedMemory();
+
+			EXPECT_EQ(hostPipe->getWarmUpTime(), std::chrono::nanoseconds::zero());
+			EXPECT_LT(CountResidentPages(*hostMemory), pageCount);
+		}
+
+		const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, {.mirrored = mirrored, .prefault = true});
+		const auto clientPipe = OpenSharedMemoryPipe("test-pipe", {}, {.prefault = true, .lock = true});
+
+		EXPECT_GT(hostPipe->getWarmUpTime(), std::chrono::nanoseconds::zero());
+		EXPECT_GT(clientPipe->getWarmUpTime(), std::chrono::nanoseconds::zero());
+		EXPECT_EQ(CountResidentPages(*hostPipe->getTxPipe().getSharedMemory()), pageCount);
+		EXPECT_EQ(CountResidentPages(*clientPipe->getRxPipe().getSharedMemory()), pageCount);
+
+		// Prefaulting the opener's mapping leaves what the host already wrote alone
+		const Packet packet {std::vector<uint8_t>(1000u, 0x5Au)};
+		hostPipe->write(packet);
+
+		const auto otherClientPipe = OpenSharedMemoryPipe("test-pipe", {}, {.prefault = true});
+		EXPECT_EQ(otherClientPipe->read().data, packet.data);
+	}
+}
+
+TEST(shared_memory_pipe, numa_placement)
+{
+	constexpr std::size_t kSharedMemorySize {1024u * 1024u};
+
+	// Prefaulted pages are in memory, so only a kernel without NUMA support cannot tell where
+	if (CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, {.prefault = true})->getTxPipe().getSharedMemory()->getNumaNode() == -1)
+	{
+		GTEST_SKIP() << "NUMA placement is not supported";
+	}
+
+	{
+		const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, {.prefault = true, .numaPolicy = NumaPolicy::Bind, .numaNode = 0u});
+		const auto clientPipe = OpenSharedMemoryPipe("test-pipe", {}, {.prefault = true});
+
+		EXPECT_EQ(hostPipe->getTxPipe().getSharedMemory()->getNumaNode(), 0);
+		EXPECT_EQ(clientPipe->getRxPipe().getSharedMemory()->getNumaNode(), 0);
+	}
+
+	// Nodes that do not exist, and interleaving on a single node, fall back to first touch
+	for (const SharedMemoryOptions& options : {SharedMemoryOptions {.mirrored = true, .numaPolicy = NumaPolicy::Interleave}, SharedMemoryOptions {.numaPolicy = NumaPolicy::Bind, .numaNode = 1000u}, SharedMemoryOptions {.numaPolicy = NumaPolicy::Bind, .numaNode = 5000u}})
+	{
+		const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, options);
+		const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+
+		const Packet packet {std::vector<uint8_t>(1000u, 0x5Au)};
+		hostPipe->write(packet);
+		EXPECT_EQ(clientPipe->read().data, packet.data);
+		EXPECT_GE(hostPipe->getTxPipe().getSharedMemory()->getNumaNode(), 0);
+	}
+}
+
+TEST(shared_memory_pipe, memfd)
+{
+	constexpr std::size_t kSharedMemorySize {64u * 1024u};
+	const Packet packet {std::vector<uint8_t>(1000u, 0x5Au)};
+
+	for (const bool mirrored : {false, true})
+	{
+		const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, {.mirrored = mirrored, .backend = SharedMemoryBackend::Memfd});
+		const auto clientPipe = OpenSharedMemoryPipe("test-pipe", {}, {.backend = SharedMemoryBackend::Memfd});
+
+		// Nothing to find by name, or to clean up after a crash
+		EXPECT_FALSE(std::filesystem::exists("/dev/shm/smipc.test-pipe.rx"));
+		EXPECT_FALSE(std::filesystem::exists("/dev/shm/smipc.test-pipe.tx"));
+
+		EXPECT_EQ(clientPipe->getRxPipe().getSharedMemory()->getSize(), hostPipe->getTxPipe().getSharedMemory()->getSize());
+		EXPECT_EQ(clientPipe->getRxPipe().getSharedMemory()->isMirrored(), mirrored);
+
+		hostPipe->write(packet);
+		EXPECT_EQ(clientPipe->read().data, packet.data);
+		clientPipe->write(packet);
+		EXPECT_EQ(hostPipe->read().data, packet.data);
+
+		// The name is taken while the creator is alive
+		EXPECT_THROW(static_cast<void>(CreateSharedMemoryPipe("test-pipe", kSharedMemorySize, {.backend = SharedMemoryBackend::Memfd})), std::runtime_error);
+	}
+
+	// And free again once it is gone
+	EXPECT_THROW(static_cast<void>(OpenSharedMemoryPipe("test-pipe", {}, {.backend = SharedMemoryBackend::Memfd})), std::runtime_error);
+
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", 3u * 1024u * 1024u, {.hugePageSize = kHugePageSize2M, .backend = SharedMemoryBackend::Memfd});
+	const std::size_t segmentPageSize {hostPipe->getTxPipe().getSharedMemory()->getPageSize()};
+	EXPECT_TRUE(segmentPageSize == kHugePageSize2M || segmentPageSize == static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+
+	// The descriptor crosses into another process
+	const pid_t child {fork()};
+	ASSERT_NE(child, -1);
+
+	if (child == 0)
+	{
+		const auto clientPipe = OpenSharedMemoryPipe("test-pipe", {}, {.backend = SharedMemoryBackend::Memfd});
+		const bool huge {clientPipe->getRxPipe().getSharedMemory()->getPageSize() == segmentPageSize};
+		const auto echo = clientPipe->read(std::chrono::seconds {5});
+
+		if (echo)
+		{
+			clientPipe->write(*echo);
+		}
+
+		_exit(huge && echo ? 0 : 1);
+	}
+
+	hostPipe->write(packet);
+	const auto echo = hostPipe->read(std::chrono::seconds {5});
+	ASSERT_TRUE(echo.has_value());
+	EXPECT_EQ(echo->data, packet.data);
+
+	int status {};
+	ASSERT_EQ(waitpid(child, &status, 0), child);
+	EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+TEST(shared_memory_pipe, failed_lock_keeps_segment)
+{
+	const auto hostPipe = CreateSharedMemoryPipe("test-pipe", kSharedMemoryViewDataOffset + RingBuffer::GetMemoryBlockSize(4096u));
+	const auto* hostMemory = hostPipe->getTxPipe().getSharedMemory();
+
+	const pid_t child {fork()};
+	ASSERT_NE(child, -1);
+
+	if (child == 0)
+	{
+		// Without CAP_IPC_LOCK a zero RLIMIT_MEMLOCK makes mlock fail, even for root
+		__user_cap_header_struct capHeader {.version = _LINUX_CAPABILITY_VERSION_3, .pid = 0};
+		__user_cap_data_struct capData[2] {};
+		syscall(SYS_capget, &capHeader, capData);
+		capData[CAP_TO_INDEX(CAP_IPC_LOCK)].effective &= ~CAP_TO_MASK(CAP_IPC_LOCK);
+		syscall(SYS_capset, &capHeader, capData);
+
+		const rlimit limit {};
+		setrlimit(RLIMIT_MEMLOCK, &limit);
+
+		try
+		{
+			static_cast<void>(OpenSharedMemoryPipe("test-pipe", {}, {.lock = true}));
+		}
+		catch (const std::runtime_error&)
+		{
+			_exit(0);
+		}
+
+		_exit(1);
+	}
+
+	int status {};
+	ASSERT_EQ(waitpid(child, &status, 0), child);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	// The failed opener gave its reference back and left the segment's name in place
+	EXPECT_EQ(*hostMemory->getView().refCount, 1u);
+
+	const auto clientPipe = OpenSharedMemoryPipe("test-pipe");
+	hostPipe->write(Packet {std::vector<uint8_t>(10u)});
+	EXPECT_EQ(clientPipe->read().data.size(), 10u);
+}
+
+TEST(shared_memory_pipe, failed_open_closes_descriptor)
+{
+	const std::size_t pageSize {static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+	const auto countDescriptors = []() { return std::distance(std::filesystem::directory_iterator {"/proc/self/fd"}, {}); };
+
+	// A segment whose header puts the mirror past its end, so mapping it fails
+	const int handle {shm_open("/smipc.test-broken", O_CREAT | O_RDWR, S_IRUSR | S_IWUSR)};
+	ASSERT_NE(handle, -1);
+	ASSERT_EQ(ftruncate(handle, static_cast<off_t>(2u * pageSize)), 0);
+
+	auto* header = static_cast<std::byte*>(mmap(nullptr, pageSize, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0));
+	ASSERT_NE(header, MAP_FAILED);
+	*reinterpret_cast<uint64_t*>(header + kSharedMemoryViewDataSizeOffset) = 2u * pageSize - kSharedMemoryViewDataOffset;
+	*reinterpret_cast<uint32_t*>(header + kSharedMemoryViewDataOffsetOffset) = kSharedMemoryViewDataOffset;
+	*reinterpret_cast<uint32_t*>(header + kSharedMemoryViewMirrorStartOffset) = static_cast<uint32_t>(4u * pageSize);
+	munmap(header, pageSize);
+	close(handle);
+
+	const auto descriptors {countDescriptors()};
+	auto sharedMemory = MakeUniqueSharedMemory();
+	EXPECT_THROW(sharedMemory->open("/smipc.test-broken"), std::runtime_error);
+	EXPECT_EQ(countDescriptors(), descriptors);
+
+	shm_unlink("/smipc.test-broken");
+}
+#endif
+
 int main(int argc, char** argv)
 {
 	testing::InitGoogleTest(&argc, argv);
@@ -28,16 +28,22 @@
 #include <libsmipc/ring-buffer/tx-ring-buffer.hpp>
 #include <libsmipc/ring-buffer/packet.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <span>
 #include <string>
 #include <cstdint>
 
+// Messages are split so that this many fragments fit in the ring at once
+static constexpr uint32_t kFragmentsInFlight {4u};
+
 class TxSharedMemoryPipe
 {
 public:
-	TxSharedMemoryPipe(std::unique_ptr<ISharedMemory>&& sharedMemory)
+	TxSharedMemoryPipe(std::unique_ptr<ISharedMemory>&& sharedMemory, const RingBufferOptions& options = {})
 		: m_sharedMemory {std::move(sharedMemory)}
-		, m_ringBuffer {reinterpret_cast<uint8_t*>(m_sharedMemory->getView().data), m_sharedMemory->getSize()}
+		, m_ringBuffer {reinterpret_cast<uint8_t*>(m_sharedMemory->getView().data), static_cast<std::size_t>(*m_sharedMemory->getView().dataSize), MakeRingBufferOptions(options, *m_sharedMemory)}
 	{}
 
 	~TxSharedMemoryPipe()
@@ -49,6 +55,99 @@ public:
 		m_ringBuffer.push(packet);
 	}
 
+	[[nodiscard]]
+	auto write(const Packet& packet, std::chrono::nanoseconds timeout) -> bool
+	{
+		return m_ringBuffer.push(packet, timeout);
+	}
+
+	[[nodiscard]]
+	auto tryWrite(const Packet& packet) -> RingBufferStatus
+	{
+		return m_ringBuffer.tryPush(packet);
+	}
+
+	/**
+	 * Write a message of any size, split into fragments that fit the ring.
+	 *
+	 * Fragments share a transfer id and carry their index and the fragment
+	 * count. Each one is pushed as soon as there is room for it, so the reader
+	 * reassembles the first fragments while the later ones are still being
+	 * written. Empty messages are skipped, as with write.
+	 *
+	 * @param message The message to send.
+	 * @param timeout How long to wait for the whole message to go out.
+	 * @return False if the timeout ran out, the reader drops the fragments
+	 * already sent.
+	 */
+	[[nodiscard]]
+	auto writeMessage(std::span<const uint8_t> message, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) -> bool
+	{
+		const uint32_t fragmentSize {getFragmentSize()};
+		const uint32_t packetCount {static_cast<uint32_t>((message.size() + fragmentSize - 1u) / fragmentSize)};
+		const uint32_t transferId {MakeTransferId()};
+		const auto start {std::chrono::steady_clock::now()};
+
+		for (uint32_t packetId = 0u; packetId < packetCount; ++packetId)
+		{
+			const std::size_t offset {static_cast<std::size_t>(packetId) * fragmentSize};
+			const auto fragment {message.subspan(offset, std::min<std::size_t>(fragmentSize, message.size() - offset))};
+			const auto elapsed {std::chrono::steady_clock::now() - start};
+			const auto remaining {timeout == std::chrono::nanoseconds::max() ? timeout : std::max(std::chrono::nanoseconds {0}, timeout - elapsed)};
+
+			if (! m_ringBuffer.push(PacketHeader {0u, 0u, packetId, packetCount, transferId}, fragment, remaining))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Get the largest payload writeMessage puts in a single fragment.
+	 */
+	[[nodiscard]]
+	auto getFragmentSize() const noexcept -> uint32_t
+	{
+		// A share of the ring, as long as it fits in a single packet
+		const uint32_t share {static_cast<uint32_t>(std::min<uint64_t>(m_ringBuffer.getCapacity() / kFragmentsInFlight, kMaxPacketSize))};
+		const uint32_t size {share > kPacketHeaderSize + kAlignment ? share - kPacketHeaderSize : static_cast<uint32_t>(kAlignment)};
+
+		return size - size % kAlignment;
+	}
+
+	auto writeBatch(std::span<const Packet> packets) -> std::size_t
+	{
+		return m_ringBuffer.pushBatch(packets);
+	}
+
+	auto writeBatch(std::span<const std::span<const uint8_t>> payloads) -> std::size_t
+	{
+		return m_ringBuffer.pushBatch(payloads);
+	}
+
+	[[nodiscard]]
+	auto reserve(std::size_t size) -> RingBufferSpan<uint8_t>
+	{
+		return m_ringBuffer.reserve(size);
+	}
+
+	void commit()
+	{
+		m_ringBuffer.commit();
+	}
+
+	void commit(std::size_t size)
+	{
+		m_ringBuffer.commit(size);
+	}
+
+	void cancel() noexcept
+	{
+		m_ringBuffer.cancel();
+	}
+
 	auto getSharedMemory() const -> const ISharedMemory*
 	{
 		return m_sharedMemory.get();
@@ -60,6 +159,13 @@ public:
 	}
 
 private:
+	// The segment decides whether the ring buffer is mirrored, the caller decides the rest
+	static auto MakeRingBufferOptions(RingBufferOptions options, const ISharedMemory& sharedMemory) -> RingBufferOptions
+	{
+		options.mirrored = sharedMemory.isMirrored();
+		return options;
+	}
+
 	std::unique_ptr<ISharedMemory> m_sharedMemory;
 	TxRingBuffer m_ringBuffer;
 };
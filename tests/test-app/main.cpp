@@ -28,8 +28,8 @@
 
 int main()
 {
-	constexpr std::size_t kSize = 128;
-	uint8_t buffer[kSize] {};
+	constexpr std::size_t kSize = RingBuffer::GetMemoryBlockSize(128u);
+	alignas(kCacheLineSize) uint8_t buffer[kSize] {};
 	TxRingBuffer tx(buffer, kSize);
 	RxRingBuffer rx(buffer, kSize);
 